@@ -0,0 +1,143 @@
+/*
+ * bench_copy_encoding.cpp
+ *
+ *  Created on:  2026-10-18
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ *
+ *  Microbenchmarks of the client side hot paths: building COPY lines for all table types,
+ *  escaping of text and hstore, encoding of geometries and tag filters. The tables are used
+ *  in demo mode, i.e. all data is sent to a null sink and no database is necessary.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <postgres_drivers/columns.hpp>
+#include <postgres_drivers/copy_encoding.hpp>
+#include <postgres_drivers/table.hpp>
+
+#include "synthetic_data.hpp"
+
+using namespace bench;
+
+namespace {
+
+    /**
+     * Prevent the compiler from optimising the benchmarked code away.
+     */
+    volatile size_t sink = 0;
+
+    /**
+     * Run a benchmark and print its throughput.
+     *
+     * \param name name of the benchmark
+     * \param iterations number of calls of func
+     * \param func benchmarked function, called with the iteration number, returns the number of bytes produced
+     */
+    template <typename TFunc>
+    void run_benchmark(const std::string& name, const size_t iterations, TFunc&& func) {
+        size_t bytes = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            bytes += func(i);
+        }
+        const auto end = std::chrono::steady_clock::now();
+        sink = sink + bytes;
+        const double seconds = std::chrono::duration<double>(end - start).count();
+        std::cout << std::left << std::setw(40) << name << std::right << std::setw(12) << iterations
+                << std::setw(12) << std::fixed << std::setprecision(1) << seconds * 1e9 / iterations << " ns/op"
+                << std::setw(12) << std::setprecision(1) << bytes / seconds / (1024 * 1024) << " MB/s\n";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    size_t iterations = 200000;
+    if (argc > 1) {
+        iterations = std::strtoul(argv[1], nullptr, 10);
+    }
+    SyntheticData data{10000};
+
+    std::cout << "benchmark                                 iterations     time/op     throughput\n";
+
+    run_benchmark("escape text", iterations, [&data](const size_t i) {
+        std::string out;
+        for (const osmium::Tag& tag : data.node(i).tags()) {
+            postgres_drivers::escape(tag.value(), out);
+        }
+        return out.size();
+    });
+
+    run_benchmark("escape hstore", iterations, [&data](const size_t i) {
+        std::string out;
+        postgres_drivers::append_hstore(data.node(i).tags(), out);
+        return out.size();
+    });
+
+    wkb_factory_type factory{osmium::geom::wkb_type::ewkb, osmium::geom::out_type::hex};
+    run_benchmark("encode point (hex EWKB)", iterations, [&](const size_t i) {
+        return factory.create_point(data.locations[i % data.locations.size()]).size();
+    });
+    run_benchmark("encode linestring, 10 nodes", iterations, [&](const size_t i) {
+        return encode_linestring(factory, data.locations, i, 10).size();
+    });
+    run_benchmark("encode multipolygon, 10 nodes", iterations, [&](const size_t i) {
+        return encode_multipolygon(factory, data.locations, i, 10).size();
+    });
+
+    postgres_drivers::Config config;
+    config.metadata = osmium::metadata_options{"all"};
+    {
+        postgres_drivers::ColumnsVector additional_columns = {
+            postgres_drivers::Column{"highway", postgres_drivers::ColumnType::TEXT, postgres_drivers::ColumnClass::TAG},
+            postgres_drivers::Column{"name", postgres_drivers::ColumnType::TEXT, postgres_drivers::ColumnClass::TAG},
+            postgres_drivers::Column{"building", postgres_drivers::ColumnType::TEXT, postgres_drivers::ColumnClass::TAG}
+        };
+        osmium::TagsFilter drop_filter{false};
+        drop_filter.add_rule(true, "source");
+        drop_filter.add_rule(true, "note");
+        std::vector<std::string> nocolumn_keys = {"description"};
+        postgres_drivers::Columns columns{config, additional_columns, drop_filter, nocolumn_keys,
+                postgres_drivers::TableType::POINT};
+        run_benchmark("tag filters", iterations, [&](const size_t i) {
+            size_t bytes = 0;
+            for (const osmium::Tag& tag : data.node(i).tags()) {
+                if (!columns.drop_filter()(tag) && columns.filter()(tag)) {
+                    bytes += std::strlen(tag.key());
+                }
+            }
+            return bytes;
+        });
+    }
+
+    const postgres_drivers::TableType types[] = {
+        postgres_drivers::TableType::POINT,
+        postgres_drivers::TableType::UNTAGGED_POINT,
+        postgres_drivers::TableType::WAYS_LINEAR,
+        postgres_drivers::TableType::WAYS_POLYGON,
+        postgres_drivers::TableType::RELATION_POLYGON,
+        postgres_drivers::TableType::RELATION_OTHER,
+        postgres_drivers::TableType::AREA,
+        postgres_drivers::TableType::NODE_WAYS,
+        postgres_drivers::TableType::RELATION_MEMBER_NODES,
+        postgres_drivers::TableType::RELATION_MEMBER_WAYS,
+        postgres_drivers::TableType::RELATION_MEMBER_RELATIONS
+    };
+    for (const postgres_drivers::TableType type : types) {
+        postgres_drivers::Columns columns{config, type};
+        postgres_drivers::Table table{columns, config};
+        table.start_copy();
+        std::string line;
+        run_benchmark(std::string{"COPY line "} + table_type_name(type), iterations, [&](const size_t i) {
+            build_line(columns, factory, data.node(i), data.locations, i, line);
+            table.send_line(line);
+            return line.size();
+        });
+        table.end_copy();
+    }
+    return 0;
+}
@@ -0,0 +1,434 @@
+/*
+ * bench_import.cpp
+ *
+ *  Created on:  2026-10-18
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ *
+ *  End-to-end benchmark of imports and diff updates. It starts a throwaway PostgreSQL cluster
+ *  (initdb on a temporary directory, connections via a Unix socket only), creates a table for
+ *  each TableType, loads synthetic data using COPY, replays a synthetic diff using the prepared
+ *  statements and writes throughput and latency percentiles as JSON.
+ *
+ *  The cluster needs the PostGIS and hstore extensions.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <postgres_drivers/columns.hpp>
+#include <postgres_drivers/table.hpp>
+
+#include "synthetic_data.hpp"
+
+using namespace bench;
+
+namespace {
+
+    struct Options {
+        /// directory containing initdb and pg_ctl, queried from pg_config if empty
+        std::string pg_bin;
+        size_t objects = 100000;
+        size_t diff_size = 10000;
+        /// JSON output file, standard output if empty
+        std::string output;
+        /// keep the cluster directory after the benchmark
+        bool keep = false;
+    };
+
+    void print_help() {
+        std::cerr << "Usage: bench_import [OPTIONS]\n\n"
+                << "  --pg-bin DIR     directory containing initdb and pg_ctl (default: pg_config --bindir)\n"
+                << "  --objects N      number of objects loaded into each table (default: 100000)\n"
+                << "  --diff N         number of objects modified by the diff (default: 10000)\n"
+                << "  --output FILE    write results to FILE instead of standard output\n"
+                << "  --keep           do not delete the database cluster\n";
+    }
+
+    Options parse_options(int argc, char* argv[]) {
+        Options options;
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (arg == "--keep") {
+                options.keep = true;
+            } else if (arg == "--help" || arg == "-h") {
+                print_help();
+                exit(0);
+            } else if (i + 1 < argc && arg == "--pg-bin") {
+                options.pg_bin = argv[++i];
+            } else if (i + 1 < argc && arg == "--objects") {
+                options.objects = std::strtoul(argv[++i], nullptr, 10);
+            } else if (i + 1 < argc && arg == "--diff") {
+                options.diff_size = std::strtoul(argv[++i], nullptr, 10);
+            } else if (i + 1 < argc && arg == "--output") {
+                options.output = argv[++i];
+            } else {
+                print_help();
+                exit(1);
+            }
+        }
+        if (options.diff_size > options.objects) {
+            std::cerr << "The diff cannot modify more objects than are loaded.\n";
+            exit(1);
+        }
+        return options;
+    }
+
+    void run_command(const std::string& command) {
+        if (std::system(command.c_str()) != 0) {
+            throw std::runtime_error("Command failed: " + command);
+        }
+    }
+
+    std::string read_command_output(const std::string& command) {
+        FILE* pipe = popen(command.c_str(), "r");
+        if (!pipe) {
+            throw std::runtime_error("Command failed: " + command);
+        }
+        std::string output;
+        char buffer[256];
+        while (fgets(buffer, sizeof(buffer), pipe)) {
+            output.append(buffer);
+        }
+        pclose(pipe);
+        while (!output.empty() && std::isspace(static_cast<unsigned char>(output.back()))) {
+            output.pop_back();
+        }
+        return output;
+    }
+
+    /**
+     * Throwaway PostgreSQL cluster listening on a Unix socket in a temporary directory.
+     *
+     * The environment variables PGHOST and PGUSER are set to make libpq connect to it.
+     */
+    class LocalCluster {
+
+        std::string m_bin;
+
+        std::string m_dir;
+
+        bool m_keep;
+
+        bool m_running = false;
+
+        std::string bin(const char* program) const {
+            return m_bin + "/" + program;
+        }
+
+        void remove_directory() {
+            if (!m_keep && !m_dir.empty()) {
+                std::system(("rm -rf " + m_dir).c_str());
+            }
+        }
+
+    public:
+        LocalCluster(const std::string& bin_dir, const bool keep) :
+            m_bin(bin_dir),
+            m_dir(),
+            m_keep(keep) {
+            if (m_bin.empty()) {
+                m_bin = read_command_output("pg_config --bindir");
+            }
+            char dir_template[] = "/tmp/cerepso-bench-XXXXXX";
+            if (!mkdtemp(dir_template)) {
+                throw std::runtime_error("Failed to create temporary directory");
+            }
+            m_dir = dir_template;
+            std::cerr << "Creating database cluster in " << m_dir << "\n";
+            try {
+                run_command(bin("initdb") + " -D " + m_dir + "/data -U postgres -A trust -E UTF8 --no-sync > "
+                        + m_dir + "/initdb.log 2>&1");
+                run_command(bin("pg_ctl") + " -D " + m_dir + "/data -l " + m_dir + "/postgres.log -w -o \"-k " + m_dir
+                        + " -c listen_addresses='' -c fsync=off -c synchronous_commit=off -c full_page_writes=off\" start"
+                        + " > /dev/null");
+            } catch (std::runtime_error&) {
+                remove_directory();
+                throw;
+            }
+            m_running = true;
+            setenv("PGHOST", m_dir.c_str(), 1);
+            setenv("PGUSER", "postgres", 1);
+        }
+
+        LocalCluster(const LocalCluster&) = delete;
+
+        LocalCluster& operator=(const LocalCluster&) = delete;
+
+        ~LocalCluster() {
+            if (m_running) {
+                std::system((bin("pg_ctl") + " -D " + m_dir + "/data -m fast -w stop > /dev/null").c_str());
+            }
+            remove_directory();
+        }
+    };
+
+    /**
+     * Table which makes the creation of the prepared statements accessible.
+     */
+    class BenchTable : public postgres_drivers::Table {
+    public:
+        BenchTable(const char* table_name, postgres_drivers::Config& config, postgres_drivers::Columns columns) :
+            postgres_drivers::Table(table_name, config, columns) {
+        }
+
+        void prepare() {
+            create_prepared_statements();
+        }
+
+        void exec(const char* statement, const std::vector<std::string>& params) {
+            std::vector<const char*> values;
+            for (const std::string& param : params) {
+                values.push_back(param.c_str());
+            }
+            PQclear(send_prepared_query(statement, static_cast<int>(values.size()), values.data()));
+        }
+    };
+
+    std::string table_name(const postgres_drivers::TableType type) {
+        std::string name = "bench_";
+        for (const char* c = table_type_name(type); *c; ++c) {
+            name.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(*c))));
+        }
+        return name;
+    }
+
+    std::string create_table_query(const std::string& name, postgres_drivers::Columns& columns) {
+        std::string query = "CREATE TABLE " + name + " (";
+        for (auto it = columns.begin(); it != columns.end(); ++it) {
+            if (it != columns.begin()) {
+                query.append(", ");
+            }
+            query.append("\"" + it->name() + "\" " + it->pg_type());
+        }
+        query.append(")");
+        return query;
+    }
+
+    /**
+     * Get the indexes used by the prepared statements of a table type.
+     */
+    std::vector<std::string> index_queries(const std::string& name, const postgres_drivers::TableType type) {
+        std::vector<std::string> queries;
+        switch (type) {
+        case postgres_drivers::TableType::NODE_WAYS:
+            queries.push_back("CREATE INDEX ON " + name + " USING btree (node_id)");
+            queries.push_back("CREATE INDEX ON " + name + " USING btree (way_id)");
+            break;
+        case postgres_drivers::TableType::RELATION_MEMBER_NODES:
+        case postgres_drivers::TableType::RELATION_MEMBER_WAYS:
+        case postgres_drivers::TableType::RELATION_MEMBER_RELATIONS:
+            queries.push_back("CREATE INDEX ON " + name + " USING btree (member_id)");
+            queries.push_back("CREATE INDEX ON " + name + " USING btree (relation_id)");
+            break;
+        default:
+            queries.push_back("CREATE INDEX ON " + name + " USING btree (osm_id)");
+        }
+        return queries;
+    }
+
+    struct LoadResult {
+        std::string table;
+        uint64_t rows = 0;
+        uint64_t bytes = 0;
+        double copy_seconds = 0;
+        double index_seconds = 0;
+    };
+
+    double seconds_since(const std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /**
+     * Replay the modification of one object using the prepared statements of a table.
+     *
+     * \returns true if the object was deleted and has to be inserted again
+     */
+    bool replay_object(BenchTable& table, postgres_drivers::TableType type, wkb_factory_type& factory,
+            SyntheticData& data, const size_t i) {
+        const std::string id = std::to_string(data.node(i).id());
+        const std::string parent_id = std::to_string(i / 8 + 1);
+        switch (type) {
+        case postgres_drivers::TableType::POINT:
+        case postgres_drivers::TableType::UNTAGGED_POINT:
+            table.get_location(data.node(i).id());
+            table.delete_object(data.node(i).id());
+            return true;
+        case postgres_drivers::TableType::WAYS_LINEAR:
+            table.exec("get_linestring", {id});
+            table.exec("update_geometry", {encode_linestring(factory, data.locations, i + 1, 10), id});
+            return false;
+        case postgres_drivers::TableType::AREA:
+            table.exec("count_osm_id", {id});
+            table.exec("update_geometry", {encode_multipolygon(factory, data.locations, i + 1, 10), id});
+            return false;
+        case postgres_drivers::TableType::RELATION_OTHER:
+            table.exec("update_relation_member_geometry", {encode_multipoint(data.locations, i, 3),
+                    encode_multilinestring(data.locations, i + 1, 2, 10), id});
+            return false;
+        case postgres_drivers::TableType::NODE_WAYS:
+            table.get_way_ids(data.node(i).id());
+            table.exec("get_nodes", {parent_id});
+            table.delete_way_node_list(i / 8 + 1);
+            return true;
+        case postgres_drivers::TableType::RELATION_MEMBER_NODES:
+        case postgres_drivers::TableType::RELATION_MEMBER_WAYS:
+        case postgres_drivers::TableType::RELATION_MEMBER_RELATIONS:
+            table.exec("get_relation_ids_by_member", {id});
+            table.exec("get_members_by_relation_id", {parent_id});
+            table.exec("delete_relation_members", {parent_id});
+            return true;
+        default:
+            table.delete_object(data.node(i).id());
+            return true;
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const Options options = parse_options(argc, argv);
+    try {
+        LocalCluster cluster{options.pg_bin, options.keep};
+
+        postgres_drivers::Config config;
+        config.m_database_name = "postgres";
+        config.metadata = osmium::metadata_options{"all"};
+        config.collect_stats = true;
+        {
+            postgres_drivers::Columns admin_columns{config, postgres_drivers::TableType::OTHER};
+            BenchTable admin{"bench_admin", config, admin_columns};
+            admin.send_query("CREATE DATABASE cerepso_bench");
+        }
+        config.m_database_name = "cerepso_bench";
+        {
+            postgres_drivers::Columns admin_columns{config, postgres_drivers::TableType::OTHER};
+            BenchTable admin{"bench_admin", config, admin_columns};
+            admin.send_query("CREATE EXTENSION postgis");
+            admin.send_query("CREATE EXTENSION hstore");
+        }
+
+        const postgres_drivers::TableType types[] = {
+            postgres_drivers::TableType::POINT,
+            postgres_drivers::TableType::UNTAGGED_POINT,
+            postgres_drivers::TableType::WAYS_LINEAR,
+            postgres_drivers::TableType::WAYS_POLYGON,
+            postgres_drivers::TableType::RELATION_POLYGON,
+            postgres_drivers::TableType::RELATION_OTHER,
+            postgres_drivers::TableType::AREA,
+            postgres_drivers::TableType::NODE_WAYS,
+            postgres_drivers::TableType::RELATION_MEMBER_NODES,
+            postgres_drivers::TableType::RELATION_MEMBER_WAYS,
+            postgres_drivers::TableType::RELATION_MEMBER_RELATIONS
+        };
+
+        std::cerr << "Generating " << options.objects << " synthetic objects\n";
+        SyntheticData data{options.objects};
+        wkb_factory_type factory{osmium::geom::wkb_type::ewkb, osmium::geom::out_type::hex};
+
+        std::vector<std::unique_ptr<BenchTable>> tables;
+        std::vector<LoadResult> load_results;
+        std::string line;
+        for (const postgres_drivers::TableType type : types) {
+            const std::string name = table_name(type);
+            postgres_drivers::Columns columns{config, type};
+            tables.emplace_back(new BenchTable{name.c_str(), config, columns});
+            BenchTable& table = *tables.back();
+            table.send_query(create_table_query(name, columns).c_str());
+
+            std::cerr << "Loading " << name << "\n";
+            LoadResult result;
+            result.table = name;
+            auto start = std::chrono::steady_clock::now();
+            table.start_copy();
+            for (size_t i = 0; i < data.size(); ++i) {
+                build_line(columns, factory, data.node(i), data.locations, i, line);
+                table.send_line(line);
+            }
+            table.end_copy();
+            result.copy_seconds = seconds_since(start);
+            result.rows = table.stats().rows;
+            result.bytes = table.stats().bytes;
+
+            start = std::chrono::steady_clock::now();
+            for (const std::string& query : index_queries(name, type)) {
+                table.send_query(query.c_str());
+            }
+            table.send_query(("ANALYZE " + name).c_str());
+            result.index_seconds = seconds_since(start);
+            load_results.push_back(result);
+
+            table.prepare();
+            table.reset_stats();
+        }
+
+        std::cerr << "Replaying diff of " << options.diff_size << " objects\n";
+        // Each object is modified at most once, like in a real diff.
+        std::mt19937 random{4711};
+        std::vector<size_t> diff_objects(data.size());
+        std::iota(diff_objects.begin(), diff_objects.end(), 0);
+        std::shuffle(diff_objects.begin(), diff_objects.end(), random);
+        diff_objects.resize(options.diff_size);
+        const auto diff_start = std::chrono::steady_clock::now();
+        for (size_t t = 0; t < tables.size(); ++t) {
+            BenchTable& table = *tables[t];
+            postgres_drivers::Columns columns = table.get_columns();
+            std::vector<size_t> reinsert;
+            table.send_begin();
+            for (const size_t i : diff_objects) {
+                if (replay_object(table, types[t], factory, data, i)) {
+                    reinsert.push_back(i);
+                }
+            }
+            if (!reinsert.empty()) {
+                table.start_copy();
+                for (const size_t i : reinsert) {
+                    build_line(columns, factory, data.node(i), data.locations, i, line);
+                    table.send_line(line);
+                }
+                table.end_copy();
+            }
+            table.commit();
+        }
+        const double diff_seconds = seconds_since(diff_start);
+
+        std::ostringstream json;
+        json << "{\"objects\":" << options.objects << ",\"diff_size\":" << options.diff_size << ",\"load\":[";
+        for (size_t t = 0; t < load_results.size(); ++t) {
+            const LoadResult& result = load_results[t];
+            json << (t ? "," : "") << "{\"table\":\"" << result.table << "\",\"rows\":" << result.rows
+                    << ",\"bytes\":" << result.bytes << ",\"copy_seconds\":" << result.copy_seconds
+                    << ",\"rows_per_second\":" << result.rows / result.copy_seconds
+                    << ",\"mb_per_second\":" << result.bytes / result.copy_seconds / (1024 * 1024)
+                    << ",\"index_seconds\":" << result.index_seconds << "}";
+        }
+        json << "],\"diff\":{\"seconds\":" << diff_seconds << ",\"objects_per_second\":"
+                << options.diff_size * tables.size() / diff_seconds << ",\"tables\":[";
+        for (size_t t = 0; t < tables.size(); ++t) {
+            json << (t ? "," : "");
+            tables[t]->stats().dump_json(json, tables[t]->get_name());
+        }
+        json << "]}}\n";
+
+        if (options.output.empty()) {
+            std::cout << json.str();
+        } else {
+            std::ofstream out{options.output};
+            out << json.str();
+        }
+    } catch (std::exception& err) {
+        std::cerr << "Benchmark failed: " << err.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,332 @@
+/*
+ * synthetic_data.hpp
+ *
+ *  Created on:  2026-10-18
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ *
+ *  Synthetic OSM-like data and COPY line encoding shared by the benchmarks.
+ */
+
+#ifndef BENCH_SYNTHETIC_DATA_HPP_
+#define BENCH_SYNTHETIC_DATA_HPP_
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/geom/wkb.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+
+#include <postgres_drivers/columns.hpp>
+#include <postgres_drivers/copy_encoding.hpp>
+
+namespace bench {
+
+    using tag_vector = std::vector<std::pair<std::string, std::string>>;
+
+    /**
+     * Synthetic OSM-like data: nodes with metadata, tags and locations.
+     */
+    class SyntheticData {
+
+        osmium::memory::Buffer m_buffer;
+
+        std::vector<size_t> m_offsets;
+
+        std::mt19937 m_random;
+
+        osmium::Location random_location() {
+            std::uniform_int_distribution<int32_t> x_dist{-1800000000, 1800000000};
+            std::uniform_int_distribution<int32_t> y_dist{-850000000, 850000000};
+            return osmium::Location{x_dist(m_random), y_dist(m_random)};
+        }
+
+        tag_vector random_tags() {
+            static const tag_vector pool = {
+                {"highway", "residential"}, {"name", "Hauptstraße"}, {"building", "yes"},
+                {"addr:street", "Rue de l'Église"}, {"addr:housenumber", "12a"}, {"amenity", "restaurant"},
+                {"source", "survey;Bing"}, {"note", "contains \"quotes\" and a \\ backslash"},
+                {"description", "multi\tline\nvalue"}, {"surface", "asphalt"}, {"oneway", "yes"},
+                {"name:en", "Main Street"}, {"maxspeed", "50"}, {"landuse", "residential"}
+            };
+            std::uniform_int_distribution<size_t> count_dist{0, 8};
+            std::uniform_int_distribution<size_t> tag_dist{0, pool.size() - 1};
+            tag_vector tags;
+            const size_t count = count_dist(m_random);
+            for (size_t i = 0; i < count; ++i) {
+                tags.push_back(pool[tag_dist(m_random)]);
+            }
+            return tags;
+        }
+
+    public:
+        std::vector<osmium::Location> locations;
+
+        explicit SyntheticData(const size_t count) :
+            m_buffer(1024 * 1024, osmium::memory::Buffer::auto_grow::yes),
+            m_offsets(),
+            m_random(42),
+            locations() {
+            using namespace osmium::builder::attr;
+            static const std::vector<std::string> users = {"Nakaner", "wambacher", "user with \\ backslash", "Ærøskøbing"};
+            for (size_t i = 0; i < count; ++i) {
+                const osmium::Location location = random_location();
+                locations.push_back(location);
+                m_offsets.push_back(osmium::builder::add_node(m_buffer,
+                        _id(static_cast<osmium::object_id_type>(i * 7 + 1)),
+                        _version(static_cast<osmium::object_version_type>(i % 20 + 1)),
+                        _cid(static_cast<osmium::changeset_id_type>(i * 3 + 1000000)),
+                        _uid(static_cast<osmium::user_id_type>(i % users.size() + 1)),
+                        _user(users[i % users.size()]),
+                        _timestamp(osmium::Timestamp{static_cast<uint32_t>(1300000000 + i)}),
+                        _location(location),
+                        _tags(random_tags())));
+            }
+        }
+
+        size_t size() const noexcept {
+            return m_offsets.size();
+        }
+
+        const osmium::Node& node(const size_t i) {
+            return m_buffer.get<osmium::Node>(m_offsets[i % m_offsets.size()]);
+        }
+    };
+
+    using wkb_factory_type = osmium::geom::WKBFactory<>;
+
+    inline std::string encode_linestring(wkb_factory_type& factory, const std::vector<osmium::Location>& locations,
+            const size_t offset, const size_t count) {
+        factory.linestring_start();
+        for (size_t i = 0; i < count; ++i) {
+            factory.linestring_add_location(locations[(offset + i) % locations.size()]);
+        }
+        return factory.linestring_finish(count);
+    }
+
+    inline std::string encode_multipolygon(wkb_factory_type& factory, const std::vector<osmium::Location>& locations,
+            const size_t offset, const size_t count) {
+        factory.multipolygon_start();
+        factory.multipolygon_polygon_start();
+        factory.multipolygon_outer_ring_start();
+        for (size_t i = 0; i < count; ++i) {
+            factory.multipolygon_add_location(locations[(offset + i) % locations.size()]);
+        }
+        factory.multipolygon_add_location(locations[offset % locations.size()]);
+        factory.multipolygon_outer_ring_finish();
+        factory.multipolygon_polygon_finish();
+        return factory.multipolygon_finish();
+    }
+
+    namespace detail {
+
+        /**
+         * Append an unsigned integer as little endian hex bytes (byte order of WKBFactory).
+         */
+        inline void append_hex(const uint64_t value, const size_t bytes, std::string& out) {
+            static const char hex[] = "0123456789ABCDEF";
+            for (size_t i = 0; i < bytes; ++i) {
+                const unsigned int byte = (value >> (8 * i)) & 0xff;
+                out.push_back(hex[byte >> 4]);
+                out.push_back(hex[byte & 0xf]);
+            }
+        }
+
+        inline void append_hex_coordinates(const osmium::Location& location, std::string& out) {
+            const double coordinates[2] = {location.lon(), location.lat()};
+            for (const double coordinate : coordinates) {
+                uint64_t bits;
+                std::memcpy(&bits, &coordinate, sizeof(bits));
+                append_hex(bits, 8, out);
+            }
+        }
+
+        /**
+         * Append the header of a (sub)geometry, the SRID is only written for the outermost geometry.
+         */
+        inline void append_hex_header(const uint32_t type, const bool with_srid, std::string& out) {
+            out.append("01");
+            append_hex(with_srid ? (type | 0x20000000) : type, 4, out);
+            if (with_srid) {
+                append_hex(4326, 4, out);
+            }
+        }
+    }
+
+    /**
+     * Encode a multipoint as hex EWKB (SRID 4326).
+     *
+     * Multi-geometries are encoded here to be independent of the multi-geometry interface of a
+     * particular libosmium version.
+     */
+    inline std::string encode_multipoint(const std::vector<osmium::Location>& locations, const size_t offset,
+            const size_t count) {
+        std::string wkb;
+        detail::append_hex_header(4, true, wkb);
+        detail::append_hex(count, 4, wkb);
+        for (size_t i = 0; i < count; ++i) {
+            detail::append_hex_header(1, false, wkb);
+            detail::append_hex_coordinates(locations[(offset + i) % locations.size()], wkb);
+        }
+        return wkb;
+    }
+
+    /**
+     * Encode a multilinestring as hex EWKB (SRID 4326).
+     */
+    inline std::string encode_multilinestring(const std::vector<osmium::Location>& locations, const size_t offset,
+            const size_t linestrings, const size_t count) {
+        std::string wkb;
+        detail::append_hex_header(5, true, wkb);
+        detail::append_hex(linestrings, 4, wkb);
+        for (size_t l = 0; l < linestrings; ++l) {
+            detail::append_hex_header(2, false, wkb);
+            detail::append_hex(count, 4, wkb);
+            for (size_t i = 0; i < count; ++i) {
+                detail::append_hex_coordinates(locations[(offset + l * count + i) % locations.size()], wkb);
+            }
+        }
+        return wkb;
+    }
+
+    /**
+     * Encode the geometry column of a table type.
+     */
+    inline std::string encode_geometry(wkb_factory_type& factory, const postgres_drivers::Column& column,
+            const std::vector<osmium::Location>& locations, const size_t i) {
+        switch (column.type()) {
+        case postgres_drivers::ColumnType::POINT:
+            return factory.create_point(locations[i % locations.size()]);
+        case postgres_drivers::ColumnType::MULTIPOINT:
+            return encode_multipoint(locations, i, 3);
+        case postgres_drivers::ColumnType::LINESTRING:
+            return encode_linestring(factory, locations, i, 10);
+        case postgres_drivers::ColumnType::MULTILINESTRING:
+            return encode_multilinestring(locations, i, 2, 10);
+        default:
+            return encode_multipolygon(factory, locations, i, 10);
+        }
+    }
+
+    inline const char* find_tag(const osmium::TagList& tags, const std::string& key) {
+        for (const osmium::Tag& tag : tags) {
+            if (key == tag.key()) {
+                return tag.value();
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * Build the COPY line of an object for the given columns.
+     */
+    inline void build_line(postgres_drivers::Columns& columns, wkb_factory_type& factory, const osmium::Node& node,
+            const std::vector<osmium::Location>& locations, const size_t i, std::string& line) {
+        line.clear();
+        for (const postgres_drivers::Column& column : columns) {
+            if (!line.empty()) {
+                line.push_back('\t');
+            }
+            switch (column.column_class()) {
+            case postgres_drivers::ColumnClass::OSM_ID:
+                if (postgres_drivers::is_osm_object_table_type(columns.get_type())) {
+                    line.append(std::to_string(node.id()));
+                } else {
+                    // Eight members per way or relation.
+                    line.append(std::to_string(i / 8 + 1));
+                }
+                break;
+            case postgres_drivers::ColumnClass::NODE_ID:
+            case postgres_drivers::ColumnClass::WAY_ID:
+            case postgres_drivers::ColumnClass::RELATION_ID:
+                line.append(std::to_string(node.id()));
+                break;
+            case postgres_drivers::ColumnClass::USERNAME:
+                postgres_drivers::escape(node.user(), line);
+                break;
+            case postgres_drivers::ColumnClass::UID:
+                line.append(std::to_string(node.uid()));
+                break;
+            case postgres_drivers::ColumnClass::VERSION:
+                line.append(std::to_string(node.version()));
+                break;
+            case postgres_drivers::ColumnClass::TIMESTAMP:
+                line.append(node.timestamp().to_iso());
+                break;
+            case postgres_drivers::ColumnClass::CHANGESET:
+                line.append(std::to_string(node.changeset()));
+                break;
+            case postgres_drivers::ColumnClass::TAGS_OTHER:
+                postgres_drivers::append_hstore(node.tags(), line, [&columns](const osmium::Tag& tag) {
+                    return !columns.filter()(tag);
+                });
+                break;
+            case postgres_drivers::ColumnClass::TAG: {
+                    const char* value = find_tag(node.tags(), column.name());
+                    if (value) {
+                        postgres_drivers::escape(value, line);
+                    } else {
+                        line.append("\\N");
+                    }
+                }
+                break;
+            case postgres_drivers::ColumnClass::GEOMETRY:
+            case postgres_drivers::ColumnClass::GEOMETRY_MULTIPOINT:
+            case postgres_drivers::ColumnClass::GEOMETRY_MULTILINESTRING:
+                line.append(encode_geometry(factory, column, locations, i));
+                break;
+            case postgres_drivers::ColumnClass::LONGITUDE:
+                line.append(std::to_string(node.location().x()));
+                break;
+            case postgres_drivers::ColumnClass::LATITUDE:
+                line.append(std::to_string(node.location().y()));
+                break;
+            case postgres_drivers::ColumnClass::ROLE:
+                line.append("outer");
+                break;
+            case postgres_drivers::ColumnClass::OTHER:
+                line.append(std::to_string(i % 2000));
+                break;
+            default:
+                line.append("\\N");
+            }
+        }
+        line.push_back('\n');
+    }
+
+    inline const char* table_type_name(const postgres_drivers::TableType type) {
+        switch (type) {
+        case postgres_drivers::TableType::POINT:
+            return "POINT";
+        case postgres_drivers::TableType::UNTAGGED_POINT:
+            return "UNTAGGED_POINT";
+        case postgres_drivers::TableType::WAYS_LINEAR:
+            return "WAYS_LINEAR";
+        case postgres_drivers::TableType::WAYS_POLYGON:
+            return "WAYS_POLYGON";
+        case postgres_drivers::TableType::RELATION_POLYGON:
+            return "RELATION_POLYGON";
+        case postgres_drivers::TableType::RELATION_OTHER:
+            return "RELATION_OTHER";
+        case postgres_drivers::TableType::AREA:
+            return "AREA";
+        case postgres_drivers::TableType::NODE_WAYS:
+            return "NODE_WAYS";
+        case postgres_drivers::TableType::RELATION_MEMBER_NODES:
+            return "RELATION_MEMBER_NODES";
+        case postgres_drivers::TableType::RELATION_MEMBER_WAYS:
+            return "RELATION_MEMBER_WAYS";
+        case postgres_drivers::TableType::RELATION_MEMBER_RELATIONS:
+            return "RELATION_MEMBER_RELATIONS";
+        default:
+            return "OTHER";
+        }
+    }
+}
+
+#endif /* BENCH_SYNTHETIC_DATA_HPP_ */
@@ -0,0 +1,139 @@
+/*
+ * adaptive_flush.hpp
+ *
+ *  Created on:  2026-10-18
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef INCLUDE_POSTGRES_DRIVERS_ADAPTIVE_FLUSH_HPP_
+#define INCLUDE_POSTGRES_DRIVERS_ADAPTIVE_FLUSH_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+namespace postgres_drivers {
+
+    /**
+     * \brief Hill climbing controller of the size at which the COPY buffer of a Table is passed to libpq.
+     *
+     * The size is changed by a factor of 1.5 at the end of each epoch (at least #min_epoch_flushes
+     * flushes and #min_epoch_duration). The controller keeps the direction of the last change as long
+     * as the throughput (bytes per second of wall time, i.e. including the time the producer needs to
+     * build the rows) does not drop by more than 5 %, otherwise it reverses the direction. If the
+     * producer had to wait for the socket during more than a quarter of the epoch, the link is
+     * saturated and the size is decreased to make the writes less bursty.
+     */
+    class AdaptiveFlushSize {
+
+        size_t m_min;
+
+        size_t m_max;
+
+        size_t m_size;
+
+        /// +1 to grow, -1 to shrink
+        int m_direction = 1;
+
+        double m_last_throughput = 0;
+
+        uint64_t m_adjustments = 0;
+
+        std::chrono::steady_clock::time_point m_epoch_start;
+
+        uint64_t m_epoch_bytes = 0;
+
+        unsigned int m_epoch_flushes = 0;
+
+        uint64_t m_epoch_stall_ns = 0;
+
+        void adjust(const double seconds) {
+            const double throughput = m_epoch_bytes / seconds;
+            if (m_last_throughput > 0 && throughput < m_last_throughput * 0.95) {
+                m_direction = -m_direction;
+            }
+            if (m_epoch_stall_ns > seconds * 0.25e9) {
+                m_direction = -1;
+            }
+            const size_t previous = m_size;
+            if (m_direction > 0) {
+                m_size = std::min(m_max, m_size + m_size / 2);
+            } else {
+                m_size = std::max(m_min, m_size - m_size / 3);
+            }
+            if (m_size == previous) {
+                // reached a bound, try the other direction next time
+                m_direction = -m_direction;
+            } else {
+                ++m_adjustments;
+            }
+            m_last_throughput = throughput;
+        }
+
+    public:
+        static constexpr unsigned int min_epoch_flushes = 16;
+
+        /// minimum duration of an epoch in nanoseconds
+        static constexpr uint64_t min_epoch_duration = 50000000;
+
+        /**
+         * \param min_size lower bound in bytes
+         * \param max_size upper bound in bytes
+         * \param initial_size initial size in bytes
+         */
+        AdaptiveFlushSize(const size_t min_size, const size_t max_size, const size_t initial_size) :
+            m_min(std::max(min_size, static_cast<size_t>(1))),
+            m_max(std::max(m_min, max_size)),
+            m_size(std::min(m_max, std::max(m_min, initial_size))),
+            m_epoch_start(std::chrono::steady_clock::now()) {
+        }
+
+        /**
+         * \brief Current flush size in bytes.
+         */
+        size_t size() const noexcept {
+            return m_size;
+        }
+
+        /**
+         * \brief Number of changes of the flush size.
+         */
+        uint64_t adjustments() const noexcept {
+            return m_adjustments;
+        }
+
+        /**
+         * \brief Start a new epoch, e.g. at the beginning of a COPY. Time between COPYs is not measured.
+         */
+        void restart() {
+            m_epoch_start = std::chrono::steady_clock::now();
+            m_epoch_bytes = 0;
+            m_epoch_flushes = 0;
+            m_epoch_stall_ns = 0;
+        }
+
+        /**
+         * \brief Record a flush and adjust the size at the end of an epoch.
+         *
+         * \param bytes number of bytes passed to libpq
+         * \param stall_ns time the producer waited for the socket to become writable
+         */
+        void record(const size_t bytes, const uint64_t stall_ns) {
+            m_epoch_bytes += bytes;
+            m_epoch_stall_ns += stall_ns;
+            if (++m_epoch_flushes < min_epoch_flushes) {
+                return;
+            }
+            const auto now = std::chrono::steady_clock::now();
+            const uint64_t elapsed = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    now - m_epoch_start).count());
+            if (elapsed < min_epoch_duration) {
+                return;
+            }
+            adjust(elapsed / 1e9);
+            restart();
+        }
+    };
+}
+
+#endif /* INCLUDE_POSTGRES_DRIVERS_ADAPTIVE_FLUSH_HPP_ */
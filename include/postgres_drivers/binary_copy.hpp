@@ -0,0 +1,199 @@
+/*
+ * binary_copy.hpp
+ *
+ *  Created on:  2026-10-18
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef INCLUDE_POSTGRES_DRIVERS_BINARY_COPY_HPP_
+#define INCLUDE_POSTGRES_DRIVERS_BINARY_COPY_HPP_
+
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <type_traits>
+
+namespace postgres_drivers {
+
+    /**
+     * \brief Format of the data sent using COPY.
+     */
+    enum class CopyFormat : char {
+        TEXT = 0,
+        /// binary format, see BinaryCopyRow
+        BINARY = 1
+    };
+
+    /**
+     * \brief Header of a COPY stream in binary format (signature, flags, header extension length).
+     */
+    inline std::string binary_copy_header() {
+        return std::string("PGCOPY\n\377\r\n\0\0\0\0\0\0\0\0\0", 19);
+    }
+
+    /**
+     * \brief Count the rows in data in the binary format of COPY.
+     *
+     * The data has to consist of complete rows. It may start with the header (see
+     * binary_copy_header()) and end with the trailer, they are not counted.
+     */
+    inline size_t count_binary_copy_rows(const char* data, const size_t size) {
+        auto read_uint = [data](const size_t pos, const size_t length) -> uint32_t {
+            uint32_t value = 0;
+            for (size_t i = 0; i < length; ++i) {
+                value = (value << 8) | static_cast<unsigned char>(data[pos + i]);
+            }
+            return value;
+        };
+        size_t pos = 0;
+        const std::string header = binary_copy_header();
+        if (size >= header.size() && std::memcmp(data, header.data(), 11) == 0) {
+            // signature, flags and the header extension
+            pos = header.size() + read_uint(15, 4);
+        }
+        size_t rows = 0;
+        while (pos + 2 <= size) {
+            const uint32_t field_count = read_uint(pos, 2);
+            pos += 2;
+            if (field_count == 0xffff) {
+                // trailer
+                break;
+            }
+            for (uint32_t i = 0; i < field_count && pos + 4 <= size; ++i) {
+                const uint32_t length = read_uint(pos, 4);
+                // a length of -1 means NULL
+                pos += 4 + (length == 0xffffffff ? 0 : length);
+            }
+            ++rows;
+        }
+        return rows;
+    }
+
+    /**
+     * \brief Encoder of a row in the binary format of COPY.
+     *
+     * Values are appended in the order of the columns of the table. All integers are big endian.
+     * Geometries are sent as EWKB (not hex encoded).
+     *
+     * \code
+     * BinaryCopyRow row{buffer, 3};
+     * row.add_int8(id);
+     * row.add_timestamptz(object.timestamp().seconds_since_epoch());
+     * row.add_bytes(ewkb.data(), ewkb.size());
+     * table.send_line(buffer);
+     * \endcode
+     */
+    class BinaryCopyRow {
+
+        std::string& m_dest;
+
+        template <typename TValue>
+        void append_big_endian(TValue value) {
+            typename std::make_unsigned<TValue>::type unsigned_value;
+            std::memcpy(&unsigned_value, &value, sizeof(value));
+            char bytes[sizeof(TValue)];
+            for (size_t i = sizeof(TValue); i > 0; --i) {
+                bytes[i - 1] = static_cast<char>(unsigned_value & 0xff);
+                unsigned_value >>= 8;
+            }
+            m_dest.append(bytes, sizeof(TValue));
+        }
+
+        void write_int4_at(const size_t pos, const int32_t value) {
+            const uint32_t unsigned_value = static_cast<uint32_t>(value);
+            for (size_t i = 0; i < 4; ++i) {
+                m_dest[pos + i] = static_cast<char>((unsigned_value >> (24 - 8 * i)) & 0xff);
+            }
+        }
+
+        void add_length(const size_t length) {
+            append_big_endian(static_cast<int32_t>(length));
+        }
+
+    public:
+        /// difference between the Unix epoch and the PostgreSQL epoch (2000-01-01) in seconds
+        static constexpr int64_t postgres_epoch_offset = 946684800;
+
+        /**
+         * \param dest string to append the row to
+         * \param field_count number of columns
+         */
+        BinaryCopyRow(std::string& dest, const int16_t field_count) :
+            m_dest(dest) {
+            append_big_endian(field_count);
+        }
+
+        void add_null() {
+            append_big_endian(static_cast<int32_t>(-1));
+        }
+
+        void add_int2(const int16_t value) {
+            add_length(sizeof(value));
+            append_big_endian(value);
+        }
+
+        void add_int4(const int32_t value) {
+            add_length(sizeof(value));
+            append_big_endian(value);
+        }
+
+        void add_int8(const int64_t value) {
+            add_length(sizeof(value));
+            append_big_endian(value);
+        }
+
+        void add_float8(const double value) {
+            int64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            add_int8(bits);
+        }
+
+        /**
+         * \brief Add a `timestamptz` value.
+         *
+         * \param seconds seconds since the Unix epoch (UTC)
+         */
+        void add_timestamptz(const std::time_t seconds) {
+            add_int8((static_cast<int64_t>(seconds) - postgres_epoch_offset) * 1000000);
+        }
+
+        /**
+         * \brief Add a `text` value (without escaping).
+         */
+        void add_text(const char* value) {
+            add_bytes(value, std::strlen(value));
+        }
+
+        /**
+         * \brief Add raw bytes, e.g. `text`, `bytea` or a geometry as EWKB.
+         */
+        void add_bytes(const char* data, const size_t size) {
+            add_length(size);
+            m_dest.append(data, size);
+        }
+
+        /**
+         * \brief Add tags as `hstore`.
+         *
+         * \tparam TTags iterable container of tags providing `key()` and `value()` (e.g. osmium::TagList)
+         */
+        template <typename TTags>
+        void add_hstore(const TTags& tags) {
+            // The length of the field and the number of pairs are written when they are known.
+            const size_t length_pos = m_dest.size();
+            add_length(0);
+            append_big_endian(static_cast<int32_t>(0));
+            int32_t count = 0;
+            for (const auto& tag : tags) {
+                add_text(tag.key());
+                add_text(tag.value());
+                ++count;
+            }
+            write_int4_at(length_pos, static_cast<int32_t>(m_dest.size() - length_pos - 4));
+            write_int4_at(length_pos + 4, count);
+        }
+    };
+}
+
+#endif /* INCLUDE_POSTGRES_DRIVERS_BINARY_COPY_HPP_ */
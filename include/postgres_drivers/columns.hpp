@@ -72,6 +72,7 @@ namespace postgres_drivers {
         CHAR_ARRAY = 7,
         TEXT = 8,
         TEXT_ARRAY = 9,
+        TIMESTAMPTZ = 10,
         HSTORE = 50,
         GEOMETRY = 100,
         POINT = 101,
@@ -136,6 +137,8 @@ namespace postgres_drivers {
             return "text";
         case ColumnType::TEXT_ARRAY:
             return "text[]";
+        case ColumnType::TIMESTAMPTZ:
+            return "timestamptz";
         case ColumnType::POINT:
             if (epsg != 0) {
                 return "geometry(Point)";
@@ -287,6 +290,27 @@ namespace postgres_drivers {
             }
         }
 
+        /**
+         * Add the metadata columns of Config::compact_metadata. User names are not stored in the table
+         * but in the user dictionary (see UserDictionary), the user ID is added instead. Columns are
+         * ordered by decreasing width to avoid alignment padding.
+         */
+        void add_compact_metadata_columns(Config& config) {
+            if (config.metadata.timestamp()) {
+                m_columns.emplace_back("osm_lastmodified", ColumnType::TIMESTAMPTZ, ColumnClass::TIMESTAMP);
+            }
+            // User and changeset IDs are 32 bit unsigned integers in libosmium but have not reached 2^31 yet.
+            if (config.metadata.uid() || config.metadata.user()) {
+                m_columns.emplace_back("osm_uid", ColumnType::INT, ColumnClass::UID);
+            }
+            if (config.metadata.version()) {
+                m_columns.emplace_back("osm_version", ColumnType::INT, ColumnClass::VERSION);
+            }
+            if (config.metadata.changeset()) {
+                m_columns.emplace_back("osm_changeset", ColumnType::INT, ColumnClass::CHANGESET);
+            }
+        }
+
     public:
         Columns() = delete;
 
@@ -314,20 +338,24 @@ namespace postgres_drivers {
         void init(Config& config, TableType type) {
             if (is_osm_object_table_type(type)) {
                 m_columns.emplace_back("osm_id", ColumnType::BIGINT, ColumnClass::OSM_ID);
-                if (config.metadata.user()) {
-                    m_columns.emplace_back("osm_user", ColumnType::TEXT, ColumnClass::USERNAME);
-                }
-                if (config.metadata.uid()) {
-                    m_columns.emplace_back("osm_uid", ColumnType::BIGINT, ColumnClass::UID);
-                }
-                if (config.metadata.version()) {
-                    m_columns.emplace_back("osm_version", ColumnType::INT, ColumnClass::VERSION);
-                }
-                if (config.metadata.timestamp()) {
-                    m_columns.emplace_back("osm_lastmodified", ColumnType::TEXT, ColumnClass::TIMESTAMP);
-                }
-                if (config.metadata.changeset()) {
-                    m_columns.emplace_back("osm_changeset", ColumnType::BIGINT, ColumnClass::CHANGESET);
+                if (config.compact_metadata) {
+                    add_compact_metadata_columns(config);
+                } else {
+                    if (config.metadata.user()) {
+                        m_columns.emplace_back("osm_user", ColumnType::TEXT, ColumnClass::USERNAME);
+                    }
+                    if (config.metadata.uid()) {
+                        m_columns.emplace_back("osm_uid", ColumnType::BIGINT, ColumnClass::UID);
+                    }
+                    if (config.metadata.version()) {
+                        m_columns.emplace_back("osm_version", ColumnType::INT, ColumnClass::VERSION);
+                    }
+                    if (config.metadata.timestamp()) {
+                        m_columns.emplace_back("osm_lastmodified", ColumnType::TEXT, ColumnClass::TIMESTAMP);
+                    }
+                    if (config.metadata.changeset()) {
+                        m_columns.emplace_back("osm_changeset", ColumnType::BIGINT, ColumnClass::CHANGESET);
+                    }
                 }
             }
             switch (type) {
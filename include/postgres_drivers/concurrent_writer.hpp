@@ -0,0 +1,442 @@
+/*
+ * concurrent_writer.hpp
+ *
+ *  Created on:  2026-10-18
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef INCLUDE_POSTGRES_DRIVERS_CONCURRENT_WRITER_HPP_
+#define INCLUDE_POSTGRES_DRIVERS_CONCURRENT_WRITER_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <boost/format.hpp>
+
+#include "table.hpp"
+
+namespace postgres_drivers {
+
+    namespace detail {
+
+        struct WriterNode {
+            std::atomic<WriterNode*> next{nullptr};
+            std::string data;
+            uint64_t sequence = 0;
+        };
+
+        /**
+         * \brief Intrusive lock-free multi-producer single-consumer queue (Dmitry Vyukov's algorithm).
+         *
+         * push() is wait-free and may be called by any thread. pop() may only be called by a single
+         * consumer thread. It returns a nullpointer if the queue is empty or if a push is not
+         * completed yet.
+         */
+        class MPSCQueue {
+
+            std::atomic<WriterNode*> m_head;
+
+            WriterNode* m_tail;
+
+            WriterNode m_stub;
+
+        public:
+            MPSCQueue() :
+                m_head(&m_stub),
+                m_tail(&m_stub),
+                m_stub() {
+            }
+
+            MPSCQueue(const MPSCQueue&) = delete;
+
+            MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+            void push(WriterNode* node) noexcept {
+                node->next.store(nullptr, std::memory_order_relaxed);
+                WriterNode* previous = m_head.exchange(node, std::memory_order_acq_rel);
+                previous->next.store(node, std::memory_order_release);
+            }
+
+            WriterNode* pop() noexcept {
+                WriterNode* tail = m_tail;
+                WriterNode* next = tail->next.load(std::memory_order_acquire);
+                if (tail == &m_stub) {
+                    if (!next) {
+                        return nullptr;
+                    }
+                    m_tail = next;
+                    tail = next;
+                    next = next->next.load(std::memory_order_acquire);
+                }
+                if (next) {
+                    m_tail = next;
+                    return tail;
+                }
+                if (tail != m_head.load(std::memory_order_acquire)) {
+                    // a producer is between exchange and linking its node
+                    return nullptr;
+                }
+                push(&m_stub);
+                next = tail->next.load(std::memory_order_acquire);
+                if (next) {
+                    m_tail = next;
+                    return tail;
+                }
+                return nullptr;
+            }
+        };
+    }
+
+    /**
+     * \brief Front-end which lets many threads send COPY data to one table.
+     *
+     * Each worker thread gets a Producer with its own buffer. Full buffers are passed through a
+     * lock-free queue to a consumer thread which owns the COPY connection of the table and
+     * writes them sequentially. The hot path of the producers (appending lines to their buffer)
+     * does not lock anything.
+     *
+     * In ordered mode, producers hand over their rows with a sequence number using
+     * Producer::commit(). The consumer writes them in the order of the sequence numbers (starting at
+     * 0, without gaps), e.g. in the order of the input buffers the workers were processing.
+     * Otherwise the order of the rows is undefined.
+     *
+     * \tparam TTable type of the table, it has to provide start_copy(), send_line() and end_copy(),
+     * e.g. Table or PartitionedTable
+     */
+    template <typename TTable = Table>
+    class ConcurrentWriter {
+
+        TTable& m_table;
+
+        size_t m_buffer_size;
+
+        bool m_ordered;
+
+        size_t m_max_queued;
+
+        detail::MPSCQueue m_queue;
+
+        /// number of buffers pushed but not yet taken by the consumer (ordered mode: not yet written)
+        std::atomic<size_t> m_queued{0};
+
+        /// ordered mode: sequence number the consumer has to write next
+        std::atomic<uint64_t> m_next_sequence{0};
+
+        std::atomic<bool> m_stop{false};
+
+        std::atomic<bool> m_failed{false};
+
+        std::atomic<bool> m_consumer_sleeping{false};
+
+        std::mutex m_mutex;
+
+        /// wakes up the consumer
+        std::condition_variable m_data_available;
+
+        /// wakes up producers waiting for space in the queue
+        std::condition_variable m_space_available;
+
+        /// first error of the consumer or a producer, protected by #m_mutex
+        std::exception_ptr m_error;
+
+        std::thread m_consumer;
+
+        bool m_finished = false;
+
+        void push(detail::WriterNode* node) {
+            const uint64_t sequence = node->sequence;
+            if (m_failed.load(std::memory_order_relaxed)) {
+                delete node;
+                throw std::runtime_error("ConcurrentWriter: writing to the table failed.\n");
+            }
+            m_queue.push(node);
+            const size_t queued = m_queued.fetch_add(1) + 1;
+            if (m_consumer_sleeping.load()) {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                m_data_available.notify_one();
+            }
+            if (queued > m_max_queued) {
+                std::unique_lock<std::mutex> lock{m_mutex};
+                while (m_queued.load() > m_max_queued && !m_failed.load() && !written(sequence)) {
+                    m_space_available.wait_for(lock, std::chrono::milliseconds(1));
+                }
+            }
+        }
+
+        /**
+         * Check if the buffer with the given sequence number has been written (ordered mode).
+         *
+         * A producer whose own buffer has been written does not wait any longer. Otherwise it could
+         * hold back the sequence number the consumer is waiting for while the reorder buffer is full.
+         */
+        bool written(const uint64_t sequence) const {
+            return m_ordered && sequence < m_next_sequence.load();
+        }
+
+        /**
+         * Store an error which is thrown by finish() and stop accepting buffers.
+         */
+        void fail(std::exception_ptr error) {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            if (!m_error) {
+                m_error = error;
+            }
+            m_failed = true;
+            m_space_available.notify_all();
+        }
+
+        /**
+         * Mark a buffer as taken by the consumer. In ordered mode, buffers count as taken when they
+         * are written, i.e. buffers in the reorder buffer still block the producers.
+         */
+        void taken() {
+            if (m_queued.fetch_sub(1) > m_max_queued) {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                m_space_available.notify_all();
+            }
+        }
+
+        detail::WriterNode* wait_for_node() {
+            for (;;) {
+                detail::WriterNode* node = m_queue.pop();
+                if (node) {
+                    return node;
+                }
+                std::unique_lock<std::mutex> lock{m_mutex};
+                m_consumer_sleeping.store(true);
+                node = m_queue.pop();
+                if (!node && !m_stop.load()) {
+                    // The timeout covers pushes which were not linked yet when pop() was called.
+                    m_data_available.wait_for(lock, std::chrono::milliseconds(1));
+                }
+                m_consumer_sleeping.store(false);
+                if (node) {
+                    return node;
+                }
+                if (m_stop.load()) {
+                    // All producers are done, the queue is empty unless a push was completed in between.
+                    return m_queue.pop();
+                }
+            }
+        }
+
+        void write(detail::WriterNode* node) {
+            if (!node->data.empty()) {
+                m_table.send_line(node->data);
+            }
+            delete node;
+        }
+
+        void consume() {
+            std::map<uint64_t, detail::WriterNode*> reorder_buffer;
+            uint64_t next_sequence = 0;
+            try {
+                while (detail::WriterNode* node = wait_for_node()) {
+                    if (!m_ordered) {
+                        taken();
+                        write(node);
+                        continue;
+                    }
+                    if (node->sequence < next_sequence || !reorder_buffer.emplace(node->sequence, node).second) {
+                        const uint64_t sequence = node->sequence;
+                        taken();
+                        delete node;
+                        throw std::runtime_error((boost::format("ConcurrentWriter: sequence number %1% was committed twice.\n")
+                                % sequence).str());
+                    }
+                    auto it = reorder_buffer.begin();
+                    while (it != reorder_buffer.end() && it->first == next_sequence) {
+                        write(it->second);
+                        it = reorder_buffer.erase(it);
+                        m_next_sequence.store(++next_sequence);
+                        taken();
+                    }
+                }
+                if (!reorder_buffer.empty()) {
+                    throw std::runtime_error((boost::format("ConcurrentWriter: sequence number %1% is missing.\n")
+                            % next_sequence).str());
+                }
+            } catch (...) {
+                fail(std::current_exception());
+                for (auto& entry : reorder_buffer) {
+                    taken();
+                    delete entry.second;
+                }
+                // discard everything else
+                while (detail::WriterNode* node = wait_for_node()) {
+                    taken();
+                    delete node;
+                }
+            }
+        }
+
+    public:
+        /**
+         * \brief Buffer of a worker thread. Use one Producer per thread.
+         */
+        class Producer {
+
+            ConcurrentWriter* m_writer;
+
+            std::string m_buffer;
+
+        public:
+            explicit Producer(ConcurrentWriter& writer) :
+                m_writer(&writer),
+                m_buffer() {
+                m_buffer.reserve(m_writer->m_buffer_size);
+            }
+
+            Producer(const Producer&) = delete;
+
+            Producer& operator=(const Producer&) = delete;
+
+            Producer(Producer&& other) :
+                m_writer(other.m_writer),
+                m_buffer(std::move(other.m_buffer)) {
+                other.m_writer = nullptr;
+            }
+
+            /**
+             * Flushes the buffer in unordered mode. In ordered mode, lines which were not committed
+             * cannot be written, ConcurrentWriter::finish() throws an exception then.
+             */
+            ~Producer() {
+                if (!m_writer) {
+                    return;
+                }
+                if (!m_writer->m_ordered) {
+                    try {
+                        flush();
+                    } catch (...) {
+                    }
+                } else if (!m_buffer.empty()) {
+                    m_writer->fail(std::make_exception_ptr(std::runtime_error(
+                            "ConcurrentWriter: a producer was destroyed with lines which were not committed.\n")));
+                }
+            }
+
+            /**
+             * \brief Append complete lines in COPY format.
+             *
+             * In unordered mode, the buffer is handed over to the consumer if it is full.
+             *
+             * \throws std::runtime_error if writing to the table has failed
+             */
+            void send_line(const std::string& line) {
+                m_buffer.append(line);
+                if (!m_writer->m_ordered && m_buffer.size() >= m_writer->m_buffer_size) {
+                    flush();
+                }
+            }
+
+            /**
+             * \brief Hand the buffer over to the consumer (unordered mode).
+             */
+            void flush() {
+                if (m_buffer.empty()) {
+                    return;
+                }
+                detail::WriterNode* node = new detail::WriterNode();
+                node->data.reserve(m_writer->m_buffer_size);
+                node->data.swap(m_buffer);
+                m_writer->push(node);
+            }
+
+            /**
+             * \brief Hand all lines sent since the last call over to the consumer (ordered mode).
+             *
+             * Every sequence number from 0 to the last one has to be committed exactly once, empty
+             * commits are allowed.
+             */
+            void commit(const uint64_t sequence) {
+                detail::WriterNode* node = new detail::WriterNode();
+                node->sequence = sequence;
+                node->data.swap(m_buffer);
+                m_writer->push(node);
+            }
+        };
+
+        /**
+         * \brief Start COPY on the table and start the consumer thread.
+         *
+         * \param table table to write to, it must not be used by other threads until finish() has returned
+         * \param buffer_size size of the buffers of the producers in bytes
+         * \param ordered write rows in the order of the sequence numbers passed to Producer::commit()
+         * \param max_queued maximum number of buffers waiting for the consumer (in ordered mode including
+         * the buffers waiting for their predecessors) before producers are blocked
+         */
+        explicit ConcurrentWriter(TTable& table, const size_t buffer_size = 1024 * 1024, const bool ordered = false,
+                const size_t max_queued = 64) :
+            m_table(table),
+            m_buffer_size(buffer_size),
+            m_ordered(ordered),
+            m_max_queued(max_queued),
+            m_queue(),
+            m_mutex(),
+            m_data_available(),
+            m_space_available(),
+            m_error(),
+            m_consumer() {
+            m_table.start_copy();
+            m_consumer = std::thread(&ConcurrentWriter::consume, this);
+        }
+
+        ConcurrentWriter(const ConcurrentWriter&) = delete;
+
+        ConcurrentWriter& operator=(const ConcurrentWriter&) = delete;
+
+        ~ConcurrentWriter() {
+            try {
+                finish();
+            } catch (...) {
+            }
+        }
+
+        /**
+         * \brief Get a new producer for a worker thread.
+         */
+        Producer producer() {
+            return Producer(*this);
+        }
+
+        /**
+         * \brief Wait until all buffers have been written and end COPY.
+         *
+         * All producers have to be flushed (or destroyed) before.
+         *
+         * \throws std::runtime_error or any other exception thrown by the table
+         */
+        void finish() {
+            if (m_finished) {
+                return;
+            }
+            m_finished = true;
+            {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                m_stop = true;
+                m_data_available.notify_one();
+            }
+            m_consumer.join();
+            std::exception_ptr error;
+            {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                error = m_error;
+            }
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            m_table.end_copy();
+        }
+    };
+}
+
+#endif /* INCLUDE_POSTGRES_DRIVERS_CONCURRENT_WRITER_HPP_ */
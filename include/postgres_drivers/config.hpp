@@ -8,11 +8,29 @@
 #ifndef INCLUDE_POSTGRES_DRIVERS_CONFIG_HPP_
 #define INCLUDE_POSTGRES_DRIVERS_CONFIG_HPP_
 
+#include <iosfwd>
 #include <string>
+#include <vector>
 
 #include <osmium/osm/metadata_options.hpp>
+#include <osmium/osm/types.hpp>
 
 namespace postgres_drivers {
+
+    class MemoryBudget;
+
+    /**
+     * \brief Storage backend for the locations of untagged nodes.
+     */
+    enum class NodeLocationsStorage : char {
+        /// table UNTAGGED_POINT in the database
+        TABLE = 0,
+        /// memory mapped file, indexed by node ID (8 bytes per node)
+        DENSE_FILE = 1,
+        /// sorted list of ID-location pairs, persisted to a file
+        SPARSE_FILE = 2
+    };
+
     /**
      * program configuration
      *
@@ -23,6 +41,42 @@ namespace postgres_drivers {
         bool m_debug = false;
         /// name of the database
         std::string m_database_name = "pgimportertest";
+
+        /**
+         * libpq connection string of the primary database. If it is empty, the database
+         * #m_database_name is used.
+         */
+        std::string primary_conninfo = "";
+
+        /**
+         * libpq connection strings of read-only replicas of the primary database.
+         *
+         * SELECT queries and prepared statements are sent to the replicas if they are executed
+         * outside of a `BEGIN` `COMMIT` block and the Table has not written recently (see
+         * #replica_pin_after_write). All other queries and COPY use the primary. The replicas are
+         * used in turn.
+         */
+        std::vector<std::string> replica_conninfos;
+
+        /**
+         * Maximum replication lag in seconds. Replicas lagging behind more are not used until their
+         * lag has decreased. The lag is not checked if this is negative. If no replica can be
+         * used, queries are sent to the primary.
+         */
+        double max_replica_lag = -1;
+
+        /**
+         * Interval in seconds between two checks of the replication lag of a replica.
+         */
+        double replica_lag_check_interval = 10;
+
+        /**
+         * Number of seconds after a write on the primary (any query which is not sent to a replica,
+         * COPY, `COMMIT`) during which the queries of the same Table are sent to the primary, too, so
+         * they see the written data. If this is negative, a Table never uses the replicas after its
+         * first write.
+         */
+        double replica_pin_after_write = -1;
         /// store tags as hstore \unsupported
         bool tags_hstore = true;
 
@@ -32,6 +86,12 @@ namespace postgres_drivers {
          */
         osmium::metadata_options metadata = osmium::metadata_options{"none"};
 
+        /**
+         * Store metadata compactly: the timestamp as `timestamptz`, user ID, version and changeset as
+         * `int` and user names only once per user in a dictionary table (see UserDictionary).
+         */
+        bool compact_metadata = false;
+
         /**
          * Create tables and columns necessary for updates.
          */
@@ -41,6 +101,126 @@ namespace postgres_drivers {
          * Create table of nodes without tags.
          */
         bool untagged_nodes = false;
+
+        /**
+         * Where to store the locations of untagged nodes if #untagged_nodes is true.
+         *
+         * The flat file storages do not need the UNTAGGED_POINT table.
+         */
+        NodeLocationsStorage node_locations_storage = NodeLocationsStorage::TABLE;
+
+        /**
+         * Path of the file used by NodeLocationsStorage::DENSE_FILE and NodeLocationsStorage::SPARSE_FILE.
+         */
+        std::string node_locations_file = "";
+
+        /**
+         * Memory in bytes each Table may use to cache results of location and way ID lookups.
+         * Caching is disabled if this is 0.
+         */
+        size_t lookup_cache_memory = 0;
+
+        /**
+         * Collect performance counters and latency histograms in each Table.
+         */
+        bool collect_stats = false;
+
+        /**
+         * Log prepared statements and SELECT queries which take longer than this number of milliseconds.
+         * The log is disabled if this is negative.
+         */
+        double slow_statement_threshold = -1;
+
+        /**
+         * Fraction (between 0 and 1) of the logged slow statements which are executed again with
+         * `EXPLAIN (ANALYZE, BUFFERS)` to add their query plan to the log.
+         */
+        double slow_statement_explain_fraction = 0;
+
+        /**
+         * Stream the slow statements are logged to. Standard error is used if this is a nullpointer.
+         */
+        std::ostream* slow_statement_log = nullptr;
+
+        /**
+         * Number of range partitions of each PartitionedTable. Values smaller than 2 still create a
+         * partitioned table, with a single partition holding all IDs. Use Table for tables which should
+         * not be partitioned.
+         */
+        unsigned int partitions = 0;
+
+        /**
+         * Expected highest node ID. Node IDs up to this value are distributed evenly among the partitions,
+         * the last partition takes all larger IDs.
+         */
+        osmium::object_id_type partition_max_node_id = 14000000000;
+
+        /**
+         * Expected highest way ID, see #partition_max_node_id.
+         */
+        osmium::object_id_type partition_max_way_id = 1500000000;
+
+        /**
+         * Expected highest relation ID, see #partition_max_node_id.
+         */
+        osmium::object_id_type partition_max_relation_id = 20000000;
+
+        /**
+         * Maximum number of tiles fetched by a single query of Table::send_tile_query().
+         */
+        size_t tile_query_batch_size = 256;
+
+        /**
+         * Size of the client side COPY buffer of each Table in bytes. Table::BUFFER_SEND_SIZE is used if
+         * it is 0.
+         */
+        size_t copy_buffer_size = 0;
+
+        /**
+         * Adapt the size at which the COPY buffer is passed to libpq to the throughput of the connection
+         * (see AdaptiveFlushSize), starting at #copy_buffer_size. The connection is switched to
+         * nonblocking mode during COPY.
+         */
+        bool adaptive_copy_buffer = false;
+
+        /**
+         * Lower bound of the adaptive COPY buffer size in bytes.
+         */
+        size_t copy_buffer_min_size = 16 * 1024;
+
+        /**
+         * Upper bound of the adaptive COPY buffer size in bytes.
+         */
+        size_t copy_buffer_max_size = 8 * 1024 * 1024;
+
+        /**
+         * Memory budget shared by the COPY buffers of all Tables using this configuration. There is no
+         * limit if it is a nullpointer. The budget has to outlive the Tables.
+         */
+        MemoryBudget* memory_budget = nullptr;
+
+        /**
+         * Record the operations on the database connection of each Table to the file
+         * `<transport_record_dir>/<table name>.transport` (see RecordingTransport). Disabled if empty.
+         */
+        std::string transport_record_dir = "";
+
+        /**
+         * Do not connect to the database but replay the recordings in this directory (see
+         * ReplayTransport). Disabled if empty.
+         */
+        std::string transport_replay_dir = "";
+
+        /**
+         * Factor applied to the recorded durations of the operations during replay. Set it to 0 to replay
+         * without any latency.
+         */
+        double replay_latency_factor = 1.0;
+
+        /**
+         * Latency in milliseconds added to each operation during replay.
+         */
+        double replay_added_latency = 0;
     };
 }
 
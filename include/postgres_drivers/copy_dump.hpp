@@ -0,0 +1,330 @@
+/*
+ * copy_dump.hpp
+ *
+ *  Created on:  2026-10-18
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ *
+ *  Programs using this file have to be linked against boost_iostreams.
+ */
+
+#ifndef INCLUDE_POSTGRES_DRIVERS_COPY_DUMP_HPP_
+#define INCLUDE_POSTGRES_DRIVERS_COPY_DUMP_HPP_
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/format.hpp>
+#include <boost/iostreams/device/file.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filter/zstd.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+#include "binary_copy.hpp"
+#include "copy_sink.hpp"
+
+namespace postgres_drivers {
+
+    enum class CopyDumpCompression : char {
+        NONE = 0,
+        ZSTD = 1,
+        GZIP = 2
+    };
+
+    inline const char* compression_to_str(const CopyDumpCompression compression) {
+        switch (compression) {
+        case CopyDumpCompression::ZSTD:
+            return "zstd";
+        case CopyDumpCompression::GZIP:
+            return "gzip";
+        default:
+            return "none";
+        }
+    }
+
+    inline CopyDumpCompression str_to_compression(const std::string& str) {
+        if (str == "zstd") {
+            return CopyDumpCompression::ZSTD;
+        }
+        if (str == "gzip") {
+            return CopyDumpCompression::GZIP;
+        }
+        if (str == "none") {
+            return CopyDumpCompression::NONE;
+        }
+        throw std::runtime_error((boost::format("Unknown compression %1%\n") % str).str());
+    }
+
+    inline const char* copy_format_to_str(const CopyFormat format) {
+        return format == CopyFormat::BINARY ? "binary" : "text";
+    }
+
+    inline CopyFormat str_to_copy_format(const std::string& str) {
+        if (str == "binary") {
+            return CopyFormat::BINARY;
+        }
+        if (str == "text") {
+            return CopyFormat::TEXT;
+        }
+        throw std::runtime_error((boost::format("Unknown COPY format %1%\n") % str).str());
+    }
+
+    struct CopyDumpChunk {
+        /// file name, relative to the directory of the manifest
+        std::string file;
+        /// number of rows
+        size_t rows;
+        /// uncompressed size in bytes
+        size_t bytes;
+        /// COPY command to load the chunk with
+        std::string copy_command;
+        CopyFormat format;
+    };
+
+    /**
+     * \brief Description of the dump of a table: compression and chunk files with their COPY commands.
+     *
+     * The manifest is a text file with one tab separated entry per line:
+     *
+     *     table	<table name>
+     *     compression	<none|zstd|gzip>
+     *     copy	<COPY command>
+     *     format	<text|binary>
+     *     chunk	<file name>	<rows>	<uncompressed bytes>
+     *
+     * `copy` and `format` apply to all following chunks. They are repeated if a later COPY session
+     * used a different command or format. Each chunk is a complete COPY stream and can be loaded
+     * independently of the others.
+     */
+    struct CopyDumpManifest {
+        std::string table;
+        CopyDumpCompression compression = CopyDumpCompression::ZSTD;
+        std::vector<CopyDumpChunk> chunks;
+
+        /**
+         * \brief Write the manifest. The file is replaced atomically.
+         *
+         * \throws std::runtime_error
+         */
+        void write(const std::string& path) const {
+            const std::string temp_path = path + ".tmp";
+            {
+                std::ofstream out{temp_path};
+                out << "table\t" << table << "\ncompression\t" << compression_to_str(compression) << '\n';
+                const CopyDumpChunk* previous = nullptr;
+                for (const CopyDumpChunk& chunk : chunks) {
+                    if (!previous || previous->copy_command != chunk.copy_command) {
+                        out << "copy\t" << chunk.copy_command << '\n';
+                    }
+                    if (!previous || previous->format != chunk.format) {
+                        out << "format\t" << copy_format_to_str(chunk.format) << '\n';
+                    }
+                    previous = &chunk;
+                    out << "chunk\t" << chunk.file << '\t' << chunk.rows << '\t' << chunk.bytes << '\n';
+                }
+                if (!out.flush()) {
+                    throw std::runtime_error((boost::format("Failed to write %1%\n") % temp_path).str());
+                }
+            }
+            if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+                throw std::runtime_error((boost::format("Failed to rename %1% to %2%\n") % temp_path % path).str());
+            }
+        }
+
+        /**
+         * \brief Read a manifest.
+         *
+         * \throws std::runtime_error
+         */
+        static CopyDumpManifest read(const std::string& path) {
+            std::ifstream in{path};
+            if (!in) {
+                throw std::runtime_error((boost::format("Failed to open %1%\n") % path).str());
+            }
+            CopyDumpManifest manifest;
+            std::string copy_command;
+            CopyFormat format = CopyFormat::TEXT;
+            std::string line;
+            while (std::getline(in, line)) {
+                const size_t tab = line.find('\t');
+                const std::string key = line.substr(0, tab);
+                const std::string value = tab == std::string::npos ? "" : line.substr(tab + 1);
+                if (key == "table") {
+                    manifest.table = value;
+                } else if (key == "copy") {
+                    copy_command = value;
+                } else if (key == "format") {
+                    format = str_to_copy_format(value);
+                } else if (key == "compression") {
+                    manifest.compression = str_to_compression(value);
+                } else if (key == "chunk") {
+                    const size_t tab2 = value.find('\t');
+                    const size_t tab3 = tab2 == std::string::npos ? tab2 : value.find('\t', tab2 + 1);
+                    if (tab2 == std::string::npos || tab3 == std::string::npos) {
+                        throw std::runtime_error((boost::format("Invalid chunk entry in %1%: %2%\n") % path % line).str());
+                    }
+                    if (copy_command.empty()) {
+                        throw std::runtime_error((boost::format("Chunk without COPY command in %1%: %2%\n") % path % line).str());
+                    }
+                    manifest.chunks.push_back(CopyDumpChunk{value.substr(0, tab2),
+                            std::stoul(value.substr(tab2 + 1, tab3 - tab2 - 1)), std::stoul(value.substr(tab3 + 1)),
+                            copy_command, format});
+                } else if (!key.empty()) {
+                    throw std::runtime_error((boost::format("Invalid entry in %1%: %2%\n") % path % line).str());
+                }
+            }
+            return manifest;
+        }
+    };
+
+    /**
+     * \brief Open a chunk file for reading and decompress it.
+     */
+    inline std::unique_ptr<boost::iostreams::filtering_istream> open_chunk_file(const std::string& path,
+            const CopyDumpCompression compression) {
+        std::unique_ptr<boost::iostreams::filtering_istream> in{new boost::iostreams::filtering_istream()};
+        if (compression == CopyDumpCompression::ZSTD) {
+            in->push(boost::iostreams::zstd_decompressor());
+        } else if (compression == CopyDumpCompression::GZIP) {
+            in->push(boost::iostreams::gzip_decompressor());
+        }
+        in->push(boost::iostreams::file_source(path, std::ios_base::binary));
+        if (!in->component<boost::iostreams::file_source>(in->size() - 1)->is_open()) {
+            throw std::runtime_error((boost::format("Failed to open %1%\n") % path).str());
+        }
+        return in;
+    }
+
+    /**
+     * \brief CopySink writing the COPY stream of a table into compressed chunk files.
+     *
+     * The chunks are called `<table>.<number>.copy.<zst|gz>` and are described by the manifest
+     * `<table>.manifest` in the same directory. A new chunk is started if the current one contains
+     * at least `chunk_size` bytes (uncompressed). The manifest is updated by every call of end(),
+     * i.e. Table::end_copy(). Each chunk records the COPY command and format of the session it was
+     * written in.
+     */
+    class CopyDumpSink : public CopySink {
+
+        std::string m_directory;
+
+        size_t m_chunk_size;
+
+        CopyDumpManifest m_manifest;
+
+        std::unique_ptr<boost::iostreams::filtering_ostream> m_out;
+
+        /// COPY command of the current session
+        std::string m_copy_command;
+
+        /// format of the current session, every chunk in binary format needs its own header
+        CopyFormat m_format = CopyFormat::TEXT;
+
+        /// the next chunk is the first one after start(), its header is part of the data
+        bool m_first_chunk = true;
+
+        std::string manifest_path() const {
+            return m_directory + "/" + m_manifest.table + ".manifest";
+        }
+
+        void open_chunk() {
+            std::string file = (boost::format("%1%.%2$05d.copy") % m_manifest.table % m_manifest.chunks.size()).str();
+            m_out.reset(new boost::iostreams::filtering_ostream());
+            if (m_manifest.compression == CopyDumpCompression::ZSTD) {
+                file.append(".zst");
+                m_out->push(boost::iostreams::zstd_compressor());
+            } else if (m_manifest.compression == CopyDumpCompression::GZIP) {
+                file.append(".gz");
+                m_out->push(boost::iostreams::gzip_compressor());
+            }
+            const std::string path = m_directory + "/" + file;
+            m_out->push(boost::iostreams::file_sink(path, std::ios_base::binary));
+            if (!m_out->component<boost::iostreams::file_sink>(m_out->size() - 1)->is_open()) {
+                m_out.reset();
+                throw std::runtime_error((boost::format("Failed to open %1%\n") % path).str());
+            }
+            m_manifest.chunks.push_back(CopyDumpChunk{file, 0, 0, m_copy_command, m_format});
+            if (m_format == CopyFormat::BINARY && !m_first_chunk) {
+                const std::string header = binary_copy_header();
+                m_out->write(header.data(), header.size());
+            }
+            m_first_chunk = false;
+        }
+
+        void close_chunk() {
+            if (!m_out) {
+                return;
+            }
+            // Popping the device flushes and closes the whole chain.
+            m_out->reset();
+            m_out.reset();
+        }
+
+    public:
+        /**
+         * \param directory directory to write the files to, it has to exist
+         * \param table_name name of the table
+         * \param compression compression of the chunk files
+         * \param chunk_size minimum size of a chunk in bytes before a new chunk is started
+         */
+        CopyDumpSink(const std::string& directory, const std::string& table_name,
+                const CopyDumpCompression compression = CopyDumpCompression::ZSTD,
+                const size_t chunk_size = 256 * 1024 * 1024) :
+            m_directory(directory),
+            m_chunk_size(chunk_size),
+            m_manifest(),
+            m_out() {
+            m_manifest.table = table_name;
+            m_manifest.compression = compression;
+        }
+
+        ~CopyDumpSink() {
+            try {
+                close_chunk();
+            } catch (...) {
+            }
+        }
+
+        const CopyDumpManifest& manifest() const noexcept {
+            return m_manifest;
+        }
+
+        void start(const std::string& copy_command, const CopyFormat format) override {
+            // end() closed the chunk of the previous session
+            m_copy_command = copy_command;
+            m_format = format;
+            m_first_chunk = true;
+        }
+
+        void write(const char* data, const size_t size) override {
+            if (!m_out) {
+                open_chunk();
+            }
+            m_out->write(data, size);
+            if (!*m_out) {
+                throw std::runtime_error((boost::format("Writing COPY dump of %1% failed\n") % m_manifest.table).str());
+            }
+            CopyDumpChunk& chunk = m_manifest.chunks.back();
+            if (m_format == CopyFormat::TEXT) {
+                chunk.rows += std::count(data, data + size, '\n');
+            } else {
+                chunk.rows += count_binary_copy_rows(data, size);
+            }
+            chunk.bytes += size;
+            if (chunk.bytes >= m_chunk_size) {
+                close_chunk();
+            }
+        }
+
+        void end() override {
+            close_chunk();
+            m_manifest.write(manifest_path());
+        }
+    };
+}
+
+#endif /* INCLUDE_POSTGRES_DRIVERS_COPY_DUMP_HPP_ */
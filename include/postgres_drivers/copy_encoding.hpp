@@ -0,0 +1,135 @@
+/*
+ * copy_encoding.hpp
+ *
+ *  Created on:  2026-10-18
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ *
+ *  The escape functions are derived from osm2pgsql.
+ */
+
+#ifndef INCLUDE_POSTGRES_DRIVERS_COPY_ENCODING_HPP_
+#define INCLUDE_POSTGRES_DRIVERS_COPY_ENCODING_HPP_
+
+#include <ctime>
+#include <string>
+
+namespace postgres_drivers {
+
+    /**
+     * \brief Escape a string for the text format of COPY and append it.
+     *
+     * \param src string to escape
+     * \param dest string to append the escaped string to
+     */
+    inline void escape(const char* src, std::string& dest) {
+        for (; *src; ++src) {
+            switch (*src) {
+            case '\\':
+                dest.append("\\\\");
+                break;
+            case '\t':
+                dest.append("\\t");
+                break;
+            case '\n':
+                dest.append("\\n");
+                break;
+            case '\r':
+                dest.append("\\r");
+                break;
+            default:
+                dest.push_back(*src);
+            }
+        }
+    }
+
+    /**
+     * \brief Escape a key or value of an hstore for the text format of COPY and append it.
+     *
+     * Quotes and backslashes are escaped for hstore first and the result is escaped for COPY.
+     *
+     * \param src string to escape
+     * \param dest string to append the escaped string to
+     */
+    inline void escape4hstore(const char* src, std::string& dest) {
+        dest.push_back('"');
+        for (; *src; ++src) {
+            switch (*src) {
+            case '"':
+                dest.append("\\\\\"");
+                break;
+            case '\\':
+                dest.append("\\\\\\\\");
+                break;
+            case '\t':
+                dest.append("\\t");
+                break;
+            case '\n':
+                dest.append("\\n");
+                break;
+            case '\r':
+                dest.append("\\r");
+                break;
+            default:
+                dest.push_back(*src);
+            }
+        }
+        dest.push_back('"');
+    }
+
+    /**
+     * \brief Append tags as hstore in the text format of COPY.
+     *
+     * \tparam TTags iterable container of tags providing `key()` and `value()` (e.g. osmium::TagList)
+     * \tparam TFilter callable returning true for tags which should be added
+     *
+     * \param tags tags to append
+     * \param dest string to append to
+     * \param filter filter which tags should be added
+     *
+     * \returns number of tags appended
+     */
+    template <typename TTags, typename TFilter>
+    inline size_t append_hstore(const TTags& tags, std::string& dest, TFilter&& filter) {
+        size_t count = 0;
+        for (const auto& tag : tags) {
+            if (!filter(tag)) {
+                continue;
+            }
+            if (count > 0) {
+                dest.push_back(',');
+            }
+            escape4hstore(tag.key(), dest);
+            dest.append("=>");
+            escape4hstore(tag.value(), dest);
+            ++count;
+        }
+        return count;
+    }
+
+    /**
+     * \brief Append a timestamp in the text format of COPY for a `timestamptz` column.
+     *
+     * \param seconds seconds since the epoch (UTC)
+     * \param dest string to append to
+     */
+    inline void append_timestamp(const std::time_t seconds, std::string& dest) {
+        std::tm tm;
+        gmtime_r(&seconds, &tm);
+        char buffer[32];
+        const size_t size = std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &tm);
+        dest.append(buffer, size);
+    }
+
+    /**
+     * \brief Append all tags as hstore in the text format of COPY.
+     *
+     * \returns number of tags appended
+     */
+    template <typename TTags>
+    inline size_t append_hstore(const TTags& tags, std::string& dest) {
+        using tag_type = decltype(*tags.begin());
+        return append_hstore(tags, dest, [](tag_type) { return true; });
+    }
+}
+
+#endif /* INCLUDE_POSTGRES_DRIVERS_COPY_ENCODING_HPP_ */
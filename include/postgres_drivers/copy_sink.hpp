@@ -0,0 +1,48 @@
+/*
+ * copy_sink.hpp
+ *
+ *  Created on:  2026-10-18
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef INCLUDE_POSTGRES_DRIVERS_COPY_SINK_HPP_
+#define INCLUDE_POSTGRES_DRIVERS_COPY_SINK_HPP_
+
+#include <cstddef>
+#include <string>
+
+#include "binary_copy.hpp"
+
+namespace postgres_drivers {
+
+    /**
+     * \brief Destination of the COPY stream of a Table which has no database connection.
+     *
+     * See CopyDumpSink in copy_dump.hpp for an implementation writing files.
+     */
+    class CopySink {
+
+    public:
+        virtual ~CopySink() = default;
+
+        /**
+         * \brief Called by Table::start_copy().
+         *
+         * \param copy_command COPY command the data is meant for, e.g. `COPY table ("a","b") FROM STDIN`
+         * \param format format of the data, binary data includes the header of the COPY stream
+         */
+        virtual void start(const std::string& copy_command, const CopyFormat format) = 0;
+
+        /**
+         * \brief Write COPY data. The data always ends at a line boundary.
+         */
+        virtual void write(const char* data, const size_t size) = 0;
+
+        /**
+         * \brief Called by Table::end_copy().
+         */
+        virtual void end() = 0;
+    };
+}
+
+#endif /* INCLUDE_POSTGRES_DRIVERS_COPY_SINK_HPP_ */
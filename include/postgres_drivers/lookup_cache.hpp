@@ -0,0 +1,217 @@
+/*
+ * lookup_cache.hpp
+ *
+ *  Created on:  2026-10-18
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef INCLUDE_POSTGRES_DRIVERS_LOOKUP_CACHE_HPP_
+#define INCLUDE_POSTGRES_DRIVERS_LOOKUP_CACHE_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <osmium/osm/types.hpp>
+
+namespace postgres_drivers {
+
+    /**
+     * \brief Hit, miss and eviction counters of a LookupCache.
+     */
+    struct LookupCacheStats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t insertions = 0;
+        uint64_t evictions = 0;
+        uint64_t invalidations = 0;
+    };
+
+    /**
+     * \brief Bounded cache for results of lookups by OSM object ID.
+     *
+     * The cache is an open addressing hash table with linear probing. If the maximum number of
+     * entries is reached, entries are evicted using the CLOCK algorithm (second chance).
+     *
+     * \tparam TValue type of the cached values
+     */
+    template <typename TValue>
+    class LookupCache {
+
+        struct Slot {
+            osmium::object_id_type key = 0;
+            TValue value{};
+            bool occupied = false;
+            /// reference bit of the CLOCK algorithm
+            bool referenced = false;
+        };
+
+        std::vector<Slot> m_slots;
+
+        size_t m_mask;
+
+        size_t m_max_entries;
+
+        size_t m_count = 0;
+
+        /// position of the hand of the CLOCK algorithm
+        size_t m_clock_hand = 0;
+
+        LookupCacheStats m_stats;
+
+        size_t home(const osmium::object_id_type key) const noexcept {
+            return static_cast<size_t>((static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ULL) >> 20) & m_mask;
+        }
+
+        /**
+         * Find the slot of a key or the empty slot where it would have to be inserted.
+         */
+        size_t find(const osmium::object_id_type key) const noexcept {
+            size_t i = home(key);
+            while (m_slots[i].occupied && m_slots[i].key != key) {
+                i = (i + 1) & m_mask;
+            }
+            return i;
+        }
+
+        /**
+         * Remove the entry in a slot and shift the following entries of its cluster backwards.
+         */
+        void erase_slot(size_t hole) {
+            size_t j = hole;
+            while (true) {
+                j = (j + 1) & m_mask;
+                if (!m_slots[j].occupied) {
+                    break;
+                }
+                const size_t k = home(m_slots[j].key);
+                // Move the entry if its home slot is not cyclically in (hole, j].
+                const bool move = (hole <= j) ? (k <= hole || k > j) : (k <= hole && k > j);
+                if (move) {
+                    m_slots[hole] = std::move(m_slots[j]);
+                    hole = j;
+                }
+            }
+            m_slots[hole] = Slot{};
+            --m_count;
+        }
+
+        void evict() {
+            while (true) {
+                Slot& slot = m_slots[m_clock_hand];
+                if (slot.occupied) {
+                    if (!slot.referenced) {
+                        erase_slot(m_clock_hand);
+                        ++m_stats.evictions;
+                        return;
+                    }
+                    slot.referenced = false;
+                }
+                m_clock_hand = (m_clock_hand + 1) & m_mask;
+            }
+        }
+
+    public:
+        /**
+         * \param max_entries maximum number of cached entries, must be larger than 0
+         */
+        explicit LookupCache(const size_t max_entries) :
+            m_slots(),
+            m_mask(0),
+            m_max_entries(max_entries),
+            m_stats() {
+            // Keep the load factor below 0.75.
+            size_t capacity = 16;
+            while (capacity * 3 < max_entries * 4) {
+                capacity *= 2;
+            }
+            m_slots.resize(capacity);
+            m_mask = capacity - 1;
+        }
+
+        /**
+         * \brief Create a cache whose hash table does not use more than the given amount of memory.
+         *
+         * \param memory maximum memory usage in bytes
+         * \param extra_bytes_per_entry estimated heap memory used by a value outside of the table
+         */
+        static LookupCache<TValue> with_memory_limit(const size_t memory, const size_t extra_bytes_per_entry = 0) {
+            // The table has up to 4/3 slots per entry, the capacity is rounded up to a power of two.
+            const size_t per_entry = sizeof(Slot) * 8 / 3 + extra_bytes_per_entry;
+            return LookupCache<TValue>{std::max(memory / per_entry, static_cast<size_t>(1))};
+        }
+
+        /**
+         * \brief Look up a key.
+         *
+         * \returns pointer to the cached value or nullptr. The pointer is valid until the next
+         * modification of the cache.
+         */
+        const TValue* get(const osmium::object_id_type key) {
+            Slot& slot = m_slots[find(key)];
+            if (!slot.occupied) {
+                ++m_stats.misses;
+                return nullptr;
+            }
+            ++m_stats.hits;
+            slot.referenced = true;
+            return &slot.value;
+        }
+
+        /**
+         * \brief Add a value or replace the cached value of a key.
+         */
+        void put(const osmium::object_id_type key, TValue value) {
+            size_t i = find(key);
+            if (!m_slots[i].occupied) {
+                if (m_count >= m_max_entries) {
+                    evict();
+                    i = find(key);
+                }
+                m_slots[i].occupied = true;
+                m_slots[i].key = key;
+                ++m_count;
+                ++m_stats.insertions;
+            }
+            m_slots[i].value = std::move(value);
+            m_slots[i].referenced = true;
+        }
+
+        /**
+         * \brief Remove a key from the cache if it is cached.
+         */
+        void invalidate(const osmium::object_id_type key) {
+            const size_t i = find(key);
+            if (m_slots[i].occupied) {
+                erase_slot(i);
+                ++m_stats.invalidations;
+            }
+        }
+
+        /**
+         * \brief Remove all entries.
+         */
+        void clear() {
+            m_stats.invalidations += m_count;
+            for (Slot& slot : m_slots) {
+                slot = Slot{};
+            }
+            m_count = 0;
+        }
+
+        size_t size() const noexcept {
+            return m_count;
+        }
+
+        size_t max_size() const noexcept {
+            return m_max_entries;
+        }
+
+        const LookupCacheStats& stats() const noexcept {
+            return m_stats;
+        }
+    };
+}
+
+#endif /* INCLUDE_POSTGRES_DRIVERS_LOOKUP_CACHE_HPP_ */
@@ -0,0 +1,280 @@
+/*
+ * memory_budget.hpp
+ *
+ *  Created on:  2026-10-18
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef INCLUDE_POSTGRES_DRIVERS_MEMORY_BUDGET_HPP_
+#define INCLUDE_POSTGRES_DRIVERS_MEMORY_BUDGET_HPP_
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace postgres_drivers {
+
+    struct MemoryBudgetStats {
+        /// memory currently used by all consumers in bytes
+        size_t usage = 0;
+        /// highest value of #usage
+        size_t peak_usage = 0;
+        /// number of buffers flushed because the soft limit was exceeded
+        uint64_t forced_flushes = 0;
+        /// number of times a producer had to wait because the hard limit was exceeded
+        uint64_t waits = 0;
+    };
+
+    /**
+     * \brief Memory budget shared by the client side buffers of multiple Tables.
+     *
+     * Consumers (e.g. the COPY buffers of Tables) register with a callback releasing their memory
+     * and report their usage using update(). If the total usage exceeds the soft limit, the largest
+     * consumers are asked to release their memory until the total is below the soft limit again. If
+     * the total usage exceeds the hard limit, update() blocks until it is at or below the hard
+     * limit again.
+     *
+     * All methods are thread-safe. Release callbacks are called by the thread which calls update()
+     * without holding the lock of the budget, they may call update() themselves. A callback of a
+     * consumer owned by another thread has to synchronize with that thread and must not throw.
+     */
+    class MemoryBudget {
+
+        struct Consumer {
+            size_t usage = 0;
+            bool releasing = false;
+            std::function<void()> release;
+        };
+
+        size_t m_soft_limit;
+
+        size_t m_hard_limit;
+
+        std::mutex m_mutex;
+
+        /// notified if memory is released or usage changes while producers are waiting
+        std::condition_variable m_changed;
+
+        std::map<size_t, Consumer> m_consumers;
+
+        size_t m_next_id = 0;
+
+        /// number of release callbacks being executed
+        size_t m_releasing = 0;
+
+        /// number of producers waiting for the usage to drop below the hard limit
+        size_t m_waiters = 0;
+
+        MemoryBudgetStats m_stats;
+
+        /**
+         * Choose the largest consumers until the total usage without them is below the soft limit.
+         * Must be called with the lock held.
+         *
+         * \param total total usage including growth which has not been applied yet
+         */
+        std::vector<std::pair<size_t, std::function<void()>>> choose_victims(const size_t total) {
+            std::vector<std::pair<size_t, size_t>> candidates; // usage, ID
+            for (auto& consumer : m_consumers) {
+                if (consumer.second.usage > 0 && !consumer.second.releasing) {
+                    candidates.emplace_back(consumer.second.usage, consumer.first);
+                }
+            }
+            std::sort(candidates.begin(), candidates.end(), std::greater<std::pair<size_t, size_t>>());
+            std::vector<std::pair<size_t, std::function<void()>>> victims;
+            size_t remaining = total;
+            for (const auto& candidate : candidates) {
+                if (remaining <= m_soft_limit) {
+                    break;
+                }
+                Consumer& consumer = m_consumers[candidate.second];
+                consumer.releasing = true;
+                victims.emplace_back(candidate.second, consumer.release);
+                remaining -= candidate.first;
+            }
+            return victims;
+        }
+
+        /**
+         * Choose victims and call their release callbacks without holding the lock.
+         *
+         * \param lock lock of #m_mutex, it is held again when this method returns
+         * \param total total usage including growth which has not been applied yet
+         *
+         * \returns number of bytes released by the victims
+         */
+        size_t release_victims(std::unique_lock<std::mutex>& lock, const size_t total) {
+            std::vector<std::pair<size_t, std::function<void()>>> victims = choose_victims(total);
+            if (victims.empty()) {
+                return 0;
+            }
+            size_t before = 0;
+            for (const auto& victim : victims) {
+                before += m_consumers[victim.first].usage;
+            }
+            m_releasing += victims.size();
+            m_stats.forced_flushes += victims.size();
+            lock.unlock();
+            std::exception_ptr error;
+            for (const auto& victim : victims) {
+                try {
+                    victim.second();
+                } catch (...) {
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+            }
+            lock.lock();
+            size_t after = 0;
+            for (const auto& victim : victims) {
+                auto it = m_consumers.find(victim.first);
+                if (it != m_consumers.end()) {
+                    it->second.releasing = false;
+                    after += it->second.usage;
+                }
+            }
+            m_releasing -= victims.size();
+            m_changed.notify_all();
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            return before > after ? before - after : 0;
+        }
+
+    public:
+        /**
+         * \param soft_limit total usage in bytes above which the largest buffers are flushed
+         * \param hard_limit total usage in bytes above which producers wait for other threads flushing their buffers
+         */
+        MemoryBudget(const size_t soft_limit, const size_t hard_limit) :
+            m_soft_limit(soft_limit),
+            m_hard_limit(std::max(soft_limit, hard_limit)),
+            m_mutex(),
+            m_changed(),
+            m_consumers(),
+            m_stats() {
+        }
+
+        MemoryBudget(const MemoryBudget&) = delete;
+
+        MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+        /**
+         * \brief Register a consumer.
+         *
+         * \param release callback which releases the memory of the consumer
+         *
+         * \returns ID of the consumer
+         */
+        size_t add_consumer(std::function<void()> release) {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            const size_t id = m_next_id++;
+            m_consumers[id].release = std::move(release);
+            return id;
+        }
+
+        /**
+         * \brief Unregister a consumer. Its usage is set to 0.
+         *
+         * If another thread is executing the release callback of the consumer, this method waits
+         * until it has returned. The callback is not called any more afterwards. Must not be called by
+         * the release callback of the consumer itself.
+         */
+        void remove_consumer(const size_t id) {
+            std::unique_lock<std::mutex> lock{m_mutex};
+            auto it = m_consumers.find(id);
+            // Another thread may be calling the release callback, it must not outlive the consumer.
+            while (it != m_consumers.end() && it->second.releasing) {
+                m_changed.wait(lock);
+                it = m_consumers.find(id);
+            }
+            if (it != m_consumers.end()) {
+                m_stats.usage -= it->second.usage;
+                m_consumers.erase(it);
+            }
+            m_changed.notify_all();
+        }
+
+        /**
+         * \brief Report the memory usage of a consumer.
+         *
+         * Report growth before the memory is allocated. If the total usage including the growth
+         * exceeds the soft limit, the largest consumers (possibly including the calling one) release
+         * their memory. If it exceeds the hard limit, this method blocks before the growth is applied
+         * until it fits. Only if no consumer is releasing memory and releasing the remaining consumers
+         * does not free anything, the growth is applied above the hard limit.
+         *
+         * \param id ID of the consumer
+         * \param usage current usage in bytes
+         */
+        void update(const size_t id, const size_t usage) {
+            std::unique_lock<std::mutex> lock{m_mutex};
+            auto it = m_consumers.find(id);
+            if (it == m_consumers.end()) {
+                return;
+            }
+            if (usage > it->second.usage) {
+                // The usage of the consumer may change (e.g. if it is released) while the lock is not held.
+                auto projected = [this, id, usage]() -> size_t {
+                    auto consumer = m_consumers.find(id);
+                    return consumer == m_consumers.end() ? 0 : m_stats.usage - consumer->second.usage + usage;
+                };
+                if (projected() > m_soft_limit) {
+                    release_victims(lock, projected());
+                }
+                if (projected() > m_hard_limit) {
+                    ++m_stats.waits;
+                    ++m_waiters;
+                    try {
+                        while (projected() > m_hard_limit) {
+                            if (m_releasing > 0) {
+                                m_changed.wait(lock);
+                            } else if (release_victims(lock, projected()) == 0) {
+                                // nothing left which could be released
+                                break;
+                            }
+                        }
+                    } catch (...) {
+                        --m_waiters;
+                        throw;
+                    }
+                    --m_waiters;
+                }
+                it = m_consumers.find(id);
+                if (it == m_consumers.end()) {
+                    return;
+                }
+            }
+            m_stats.usage = m_stats.usage - it->second.usage + usage;
+            it->second.usage = usage;
+            m_stats.peak_usage = std::max(m_stats.peak_usage, m_stats.usage);
+            if (m_waiters > 0) {
+                m_changed.notify_all();
+            }
+        }
+
+        size_t usage() {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            return m_stats.usage;
+        }
+
+        size_t peak_usage() {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            return m_stats.peak_usage;
+        }
+
+        MemoryBudgetStats stats() {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            return m_stats;
+        }
+    };
+}
+
+#endif /* INCLUDE_POSTGRES_DRIVERS_MEMORY_BUDGET_HPP_ */
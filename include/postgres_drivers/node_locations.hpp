@@ -0,0 +1,427 @@
+/*
+ * node_locations.hpp
+ *
+ *  Created on:  2026-10-18
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef INCLUDE_POSTGRES_DRIVERS_NODE_LOCATIONS_HPP_
+#define INCLUDE_POSTGRES_DRIVERS_NODE_LOCATIONS_HPP_
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+#include "table.hpp"
+
+namespace postgres_drivers {
+
+    /**
+     * \brief Interface of all storage backends for the locations of untagged nodes.
+     *
+     * Locations which are not stored are returned as undefined locations.
+     */
+    class NodeLocations {
+    public:
+        virtual ~NodeLocations() = default;
+
+        /**
+         * \brief Add a location or replace the stored location of a node.
+         */
+        virtual void set(const osmium::object_id_type id, const osmium::Location location) = 0;
+
+        /**
+         * \brief Get the location of a node.
+         *
+         * \returns location or an undefined location if the node is unknown
+         */
+        virtual osmium::Location get(const osmium::object_id_type id) = 0;
+
+        /**
+         * \brief Remove the location of a node.
+         */
+        virtual void remove(const osmium::object_id_type id) = 0;
+
+        /**
+         * \brief Write pending changes to the disk or the database.
+         */
+        virtual void flush() {
+        }
+    };
+
+    /**
+     * \brief Node locations stored in the UNTAGGED_POINT table.
+     *
+     * Every lookup is a round trip to the database using the prepared statement
+     * `get_location_from_untagged_nodes_table` unless it is answered by the lookup cache of the table.
+     * The prepared statements of the table have to be created before.
+     *
+     * COPY can only append rows. It does not replace the row of a node which is already in the
+     * table. Therefore, COPY mode may only be used by imports into an empty table.
+     */
+    class TableNodeLocations : public NodeLocations {
+
+        Table& m_table;
+
+        std::string m_line;
+
+        bool m_import;
+
+    public:
+        /**
+         * \param table table of untagged nodes
+         * \param import True if the table is filled by an import and does not contain any nodes yet.
+         * Only imports may write the locations using COPY.
+         */
+        explicit TableNodeLocations(Table& table, const bool import = false) :
+            m_table(table),
+            m_line(),
+            m_import(import) {
+        }
+
+        /**
+         * Locations are written using COPY if the table is in COPY mode and using prepared
+         * statements otherwise. Metadata columns of the table are set to NULL.
+         *
+         * \throws std::runtime_error if the table is in COPY mode but this is not an import
+         */
+        void set(const osmium::object_id_type id, const osmium::Location location) override {
+            if (m_table.get_copy()) {
+                if (!m_import) {
+                    throw std::runtime_error((boost::format("Cannot replace the location of node %1% using COPY. "
+                            "COPY into table %2% is only allowed during imports.\n") % id % m_table.get_name()).str());
+                }
+                m_line.clear();
+                for (const Column& column : m_table.get_columns()) {
+                    if (!m_line.empty()) {
+                        m_line.push_back('\t');
+                    }
+                    switch (column.column_class()) {
+                    case ColumnClass::OSM_ID:
+                        m_line.append(std::to_string(id));
+                        break;
+                    case ColumnClass::LONGITUDE:
+                        m_line.append(std::to_string(location.x()));
+                        break;
+                    case ColumnClass::LATITUDE:
+                        m_line.append(std::to_string(location.y()));
+                        break;
+                    default:
+                        m_line.append("\\N");
+                    }
+                }
+                m_line.push_back('\n');
+                m_table.send_line(m_line);
+                return;
+            }
+            remove(id);
+            std::string id_str = std::to_string(id);
+            std::string x_str = std::to_string(location.x());
+            std::string y_str = std::to_string(location.y());
+            const char* param_values[] = {id_str.c_str(), x_str.c_str(), y_str.c_str()};
+            PQclear(m_table.send_prepared_query("insert_untagged_node", 3, param_values));
+        }
+
+        osmium::Location get(const osmium::object_id_type id) override {
+            return m_table.get_location(id);
+        }
+
+        void remove(const osmium::object_id_type id) override {
+            m_table.delete_object(id);
+        }
+    };
+
+    /**
+     * \brief Node locations stored in a memory mapped file which is indexed by the node ID.
+     *
+     * Each node uses 8 bytes, independent of whether it exists or not. This is the fastest
+     * storage for planet files. Negative IDs are not supported.
+     */
+    class DenseFileNodeLocations : public NodeLocations {
+
+        /**
+         * minimum number of entries the file grows by
+         */
+        static constexpr size_t GROW_STEP = 1024 * 1024;
+
+        std::string m_filename;
+
+        int m_fd;
+
+        osmium::Location* m_data = nullptr;
+
+        /// number of entries of the mapping
+        size_t m_size = 0;
+
+        void map(const size_t size) {
+            if (m_data) {
+                munmap(m_data, m_size * sizeof(osmium::Location));
+                m_data = nullptr;
+                m_size = 0;
+            }
+            if (size == 0) {
+                return;
+            }
+            void* addr = mmap(nullptr, size * sizeof(osmium::Location), PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+            if (addr == MAP_FAILED) {
+                throw std::runtime_error((boost::format("Failed to map node locations file %1%: %2%\n") % m_filename % strerror(errno)).str());
+            }
+            m_data = static_cast<osmium::Location*>(addr);
+            m_size = size;
+        }
+
+        void grow(const size_t min_size) {
+            const size_t old_size = m_size;
+            const size_t new_size = std::max(min_size + GROW_STEP, old_size * 2);
+            if (ftruncate(m_fd, new_size * sizeof(osmium::Location)) != 0) {
+                throw std::runtime_error((boost::format("Failed to resize node locations file %1%: %2%\n") % m_filename % strerror(errno)).str());
+            }
+            map(new_size);
+            // ftruncate fills the file with zeros but (0, 0) is a valid location.
+            std::fill(m_data + old_size, m_data + new_size, osmium::Location{});
+        }
+
+    public:
+        explicit DenseFileNodeLocations(const std::string& filename) :
+            m_filename(filename),
+            m_fd(open(filename.c_str(), O_RDWR | O_CREAT, 0644)) {
+            if (m_fd < 0) {
+                throw std::runtime_error((boost::format("Failed to open node locations file %1%: %2%\n") % m_filename % strerror(errno)).str());
+            }
+            struct stat file_stat;
+            if (fstat(m_fd, &file_stat) != 0) {
+                close(m_fd);
+                throw std::runtime_error((boost::format("Failed to stat node locations file %1%: %2%\n") % m_filename % strerror(errno)).str());
+            }
+            map(file_stat.st_size / sizeof(osmium::Location));
+        }
+
+        DenseFileNodeLocations(const DenseFileNodeLocations&) = delete;
+
+        DenseFileNodeLocations& operator=(const DenseFileNodeLocations&) = delete;
+
+        ~DenseFileNodeLocations() {
+            map(0);
+            close(m_fd);
+        }
+
+        void set(const osmium::object_id_type id, const osmium::Location location) override {
+            if (id < 0) {
+                throw std::runtime_error((boost::format("Node %1% has a negative ID which is not supported by the dense node location storage.\n") % id).str());
+            }
+            const size_t index = static_cast<size_t>(id);
+            if (index >= m_size) {
+                grow(index + 1);
+            }
+            m_data[index] = location;
+        }
+
+        osmium::Location get(const osmium::object_id_type id) override {
+            if (id < 0 || static_cast<size_t>(id) >= m_size) {
+                return osmium::Location{};
+            }
+            return m_data[id];
+        }
+
+        void remove(const osmium::object_id_type id) override {
+            if (id >= 0 && static_cast<size_t>(id) < m_size) {
+                m_data[id] = osmium::Location{};
+            }
+        }
+
+        void flush() override {
+            if (m_data && msync(m_data, m_size * sizeof(osmium::Location), MS_SYNC) != 0) {
+                throw std::runtime_error((boost::format("Failed to sync node locations file %1%: %2%\n") % m_filename % strerror(errno)).str());
+            }
+        }
+    };
+
+    /**
+     * \brief Node locations stored as a sorted list of ID-location pairs.
+     *
+     * This storage is intended for small extracts. The list is kept in memory and written
+     * to a file by flush() and by the destructor. It uses 16 bytes per existing node.
+     */
+    class SparseFileNodeLocations : public NodeLocations {
+
+        using entry_type = std::pair<osmium::object_id_type, osmium::Location>;
+
+        std::string m_filename;
+
+        std::vector<entry_type> m_entries;
+
+        /// number of entries at the beginning of #m_entries which are sorted
+        size_t m_sorted_size = 0;
+
+        static bool compare_ids(const entry_type& lhs, const entry_type& rhs) {
+            return lhs.first < rhs.first;
+        }
+
+        std::vector<entry_type>::iterator find_sorted(const osmium::object_id_type id) {
+            auto end = m_entries.begin() + m_sorted_size;
+            auto it = std::lower_bound(m_entries.begin(), end, entry_type{id, osmium::Location{}}, compare_ids);
+            if (it != end && it->first == id) {
+                return it;
+            }
+            return m_entries.end();
+        }
+
+        /**
+         * Sort the appended entries into the list. Appended entries never have an ID which is
+         * in the sorted part of the list already.
+         */
+        void sort() {
+            if (m_sorted_size == m_entries.size()) {
+                return;
+            }
+            auto middle = m_entries.begin() + m_sorted_size;
+            std::stable_sort(middle, m_entries.end(), compare_ids);
+            // If an ID was appended multiple times, only the last one is valid.
+            auto last = std::unique(m_entries.rbegin(), std::reverse_iterator<std::vector<entry_type>::iterator>(middle),
+                    [](const entry_type& lhs, const entry_type& rhs) { return lhs.first == rhs.first; });
+            m_entries.erase(middle, last.base());
+            std::inplace_merge(m_entries.begin(), m_entries.begin() + m_sorted_size, m_entries.end(), compare_ids);
+            m_sorted_size = m_entries.size();
+        }
+
+    public:
+        explicit SparseFileNodeLocations(const std::string& filename) :
+            m_filename(filename),
+            m_entries() {
+            int fd = open(filename.c_str(), O_RDONLY);
+            if (fd < 0) {
+                if (errno == ENOENT) {
+                    return;
+                }
+                throw std::runtime_error((boost::format("Failed to open node locations file %1%: %2%\n") % m_filename % strerror(errno)).str());
+            }
+            struct stat file_stat;
+            if (fstat(fd, &file_stat) != 0) {
+                close(fd);
+                throw std::runtime_error((boost::format("Failed to stat node locations file %1%: %2%\n") % m_filename % strerror(errno)).str());
+            }
+            m_entries.resize(file_stat.st_size / sizeof(entry_type));
+            char* buffer = reinterpret_cast<char*>(m_entries.data());
+            size_t to_read = m_entries.size() * sizeof(entry_type);
+            while (to_read > 0) {
+                ssize_t bytes_read = read(fd, buffer, to_read);
+                if (bytes_read <= 0) {
+                    close(fd);
+                    throw std::runtime_error((boost::format("Failed to read node locations file %1%\n") % m_filename).str());
+                }
+                buffer += bytes_read;
+                to_read -= bytes_read;
+            }
+            close(fd);
+            m_sorted_size = m_entries.size();
+        }
+
+        SparseFileNodeLocations(const SparseFileNodeLocations&) = delete;
+
+        SparseFileNodeLocations& operator=(const SparseFileNodeLocations&) = delete;
+
+        ~SparseFileNodeLocations() {
+            try {
+                flush();
+            } catch (std::runtime_error&) {
+            }
+        }
+
+        void set(const osmium::object_id_type id, const osmium::Location location) override {
+            auto it = find_sorted(id);
+            if (it != m_entries.end()) {
+                it->second = location;
+            } else {
+                m_entries.emplace_back(id, location);
+            }
+        }
+
+        osmium::Location get(const osmium::object_id_type id) override {
+            sort();
+            auto it = find_sorted(id);
+            if (it == m_entries.end()) {
+                return osmium::Location{};
+            }
+            return it->second;
+        }
+
+        /**
+         * Removed entries are kept as undefined locations until the next flush.
+         */
+        void remove(const osmium::object_id_type id) override {
+            set(id, osmium::Location{});
+        }
+
+        void flush() override {
+            sort();
+            m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(),
+                    [](const entry_type& entry) { return !entry.second.is_defined(); }), m_entries.end());
+            m_sorted_size = m_entries.size();
+            std::string tmp_filename = m_filename + ".tmp";
+            int fd = open(tmp_filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd < 0) {
+                throw std::runtime_error((boost::format("Failed to open node locations file %1%: %2%\n") % tmp_filename % strerror(errno)).str());
+            }
+            const char* buffer = reinterpret_cast<const char*>(m_entries.data());
+            size_t to_write = m_entries.size() * sizeof(entry_type);
+            while (to_write > 0) {
+                ssize_t written = write(fd, buffer, to_write);
+                if (written <= 0) {
+                    close(fd);
+                    throw std::runtime_error((boost::format("Failed to write node locations file %1%: %2%\n") % tmp_filename % strerror(errno)).str());
+                }
+                buffer += written;
+                to_write -= written;
+            }
+            if (close(fd) != 0 || rename(tmp_filename.c_str(), m_filename.c_str()) != 0) {
+                throw std::runtime_error((boost::format("Failed to write node locations file %1%: %2%\n") % m_filename % strerror(errno)).str());
+            }
+        }
+    };
+
+    /**
+     * \brief Create the node location storage selected by Config::node_locations_storage.
+     *
+     * \param config configuration
+     * \param untagged_nodes_table table of untagged nodes, only used by NodeLocationsStorage::TABLE
+     * \param import True if the locations are written by an import into an empty table. Only imports
+     * may write to the table of untagged nodes using COPY.
+     *
+     * \throws std::runtime_error if the configuration is incomplete
+     */
+    inline std::unique_ptr<NodeLocations> make_node_locations(Config& config, Table* untagged_nodes_table,
+            const bool import = false) {
+        switch (config.node_locations_storage) {
+        case NodeLocationsStorage::DENSE_FILE:
+            if (config.node_locations_file.empty()) {
+                throw std::runtime_error("The dense node location storage needs a file name.\n");
+            }
+            return std::unique_ptr<NodeLocations>{new DenseFileNodeLocations(config.node_locations_file)};
+        case NodeLocationsStorage::SPARSE_FILE:
+            if (config.node_locations_file.empty()) {
+                throw std::runtime_error("The sparse node location storage needs a file name.\n");
+            }
+            return std::unique_ptr<NodeLocations>{new SparseFileNodeLocations(config.node_locations_file)};
+        default:
+            if (!untagged_nodes_table) {
+                throw std::runtime_error("The node location storage in the database needs the table of untagged nodes.\n");
+            }
+            return std::unique_ptr<NodeLocations>{new TableNodeLocations(*untagged_nodes_table, import)};
+        }
+    }
+}
+
+#endif /* INCLUDE_POSTGRES_DRIVERS_NODE_LOCATIONS_HPP_ */
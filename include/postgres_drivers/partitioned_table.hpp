@@ -0,0 +1,436 @@
+/*
+ * partitioned_table.hpp
+ *
+ *  Created on:  2026-10-18
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef INCLUDE_POSTGRES_DRIVERS_PARTITIONED_TABLE_HPP_
+#define INCLUDE_POSTGRES_DRIVERS_PARTITIONED_TABLE_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <osmium/osm/types.hpp>
+
+#include "columns.hpp"
+#include "config.hpp"
+#include "table.hpp"
+
+namespace postgres_drivers {
+
+    /**
+     * \brief Range partitioning of a table by the OSM ID of the object (osm_id) or the parent object
+     * (way_id or relation_id of the member tables).
+     *
+     * Partition `i` covers the IDs in `[lower_bounds[i], lower_bounds[i + 1])`. The first partition
+     * starts at MINVALUE, the last one ends at MAXVALUE.
+     */
+    class PartitionScheme {
+
+        std::string m_key_column;
+
+        /// index of the key column in the COPY lines
+        size_t m_key_index = 0;
+
+        std::vector<osmium::object_id_type> m_lower_bounds;
+
+        static osmium::object_id_type max_id(const Config& config, const TableType type) {
+            switch (type) {
+            case TableType::POINT:
+            case TableType::UNTAGGED_POINT:
+                return config.partition_max_node_id;
+            case TableType::RELATION_POLYGON:
+            case TableType::RELATION_OTHER:
+            case TableType::RELATION_MEMBER_NODES:
+            case TableType::RELATION_MEMBER_WAYS:
+            case TableType::RELATION_MEMBER_RELATIONS:
+                return config.partition_max_relation_id;
+            case TableType::AREA:
+                // Area IDs are twice the way ID or twice the relation ID plus one.
+                return 2 * config.partition_max_way_id;
+            default:
+                return config.partition_max_way_id;
+            }
+        }
+
+    public:
+        /**
+         * \param config configuration (number of partitions and expected highest IDs)
+         * \param columns columns of the table, the partition key is the column of class ColumnClass::OSM_ID
+         *
+         * \throws std::runtime_error if the table has no column of class ColumnClass::OSM_ID
+         */
+        PartitionScheme(const Config& config, Columns& columns) :
+            m_key_column(),
+            m_lower_bounds() {
+            auto it = std::find_if(columns.begin(), columns.end(), [](const Column& column) {
+                return column.column_class() == ColumnClass::OSM_ID;
+            });
+            if (it == columns.end()) {
+                throw std::runtime_error("Cannot partition a table without an OSM ID column.\n");
+            }
+            m_key_column = it->name();
+            m_key_index = static_cast<size_t>(it - columns.begin());
+            const osmium::object_id_type count = std::max(config.partitions, 1u);
+            const osmium::object_id_type step = (max_id(config, columns.get_type()) + count - 1) / count;
+            m_lower_bounds.push_back(0);
+            for (osmium::object_id_type i = 1; i < count; ++i) {
+                m_lower_bounds.push_back(i * step);
+            }
+        }
+
+        size_t size() const noexcept {
+            return m_lower_bounds.size();
+        }
+
+        const std::string& key_column() const noexcept {
+            return m_key_column;
+        }
+
+        size_t key_index() const noexcept {
+            return m_key_index;
+        }
+
+        /**
+         * \brief Get the index of the partition containing an ID.
+         */
+        size_t partition_of(const osmium::object_id_type id) const {
+            auto it = std::upper_bound(m_lower_bounds.begin() + 1, m_lower_bounds.end(), id);
+            return static_cast<size_t>(it - m_lower_bounds.begin()) - 1;
+        }
+
+        static std::string partition_name(const std::string& table_name, const size_t index) {
+            return table_name + "_p" + std::to_string(index);
+        }
+
+        /**
+         * \brief Get the `FOR VALUES` clause of a partition.
+         */
+        std::string bounds(const size_t index) const {
+            std::string clause = "FOR VALUES FROM (";
+            clause.append(index == 0 ? "MINVALUE" : std::to_string(m_lower_bounds[index]));
+            clause.append(") TO (");
+            clause.append(index + 1 == m_lower_bounds.size() ? "MAXVALUE" : std::to_string(m_lower_bounds[index + 1]));
+            clause.push_back(')');
+            return clause;
+        }
+    };
+
+    namespace detail {
+
+        /**
+         * \brief Parent table of a PartitionedTable, makes the standard prepared statements of Table
+         * accessible.
+         */
+        class PartitionParent : public Table {
+
+        public:
+            PartitionParent(const char* table_name, Config& config, Columns columns, std::unique_ptr<Transport> transport) :
+                Table(table_name, config, columns, std::move(transport)) {
+            }
+
+            using Table::connect;
+
+            using Table::create_prepared_statements;
+        };
+    }
+
+    /**
+     * \brief Table which is range partitioned by the OSM ID (declarative partitioning, PostgreSQL 11 or newer).
+     *
+     * Every partition has its own connection. Rows sent using COPY are routed directly to their partition.
+     * Queries and prepared statements are sent to the partitioned (parent) table and benefit from partition
+     * pruning if they filter by the partition key. Lookups by other columns (e.g. `get_way_ids`) have to
+     * scan the indexes of all partitions.
+     */
+    class PartitionedTable {
+
+    public:
+        /**
+         * \brief Function creating the connection of a table (the parent or a partition) by its name.
+         */
+        using TransportFactory = std::function<std::unique_ptr<Transport>(const std::string& table_name)>;
+
+    private:
+        std::string m_name;
+
+        Columns m_columns;
+
+        PartitionScheme m_scheme;
+
+        /// connection to the partitioned table, used for DDL, queries and prepared statements
+        detail::PartitionParent m_parent;
+
+        std::vector<std::unique_ptr<Table>> m_partitions;
+
+        /// buffer for single lines routed to a partition
+        std::string m_line;
+
+        CopyFormat m_copy_format = CopyFormat::TEXT;
+
+        /**
+         * Parse the partition key of a line.
+         */
+        osmium::object_id_type key_of(const char* line, const char* end) const {
+            for (size_t i = 0; i < m_scheme.key_index(); ++i) {
+                line = std::find(line, end, '\t');
+                if (line == end) {
+                    break;
+                }
+                ++line;
+            }
+            char* key_end;
+            const osmium::object_id_type key = std::strtoll(line, &key_end, 10);
+            if (line == end || key_end == line) {
+                throw std::runtime_error((boost::format("Insertion via COPY into %1% failed: Line has no valid value in column %2%\n%3%")
+                        % m_name % m_scheme.key_column() % std::string(line, end)).str());
+            }
+            return key;
+        }
+
+        /**
+         * Parse the partition key of a row in binary format (see BinaryCopyRow).
+         *
+         * \returns end of the row
+         */
+        const char* binary_key_of(const char* row, const char* end, osmium::object_id_type& key) const {
+            auto read_uint = [](const char* data, const size_t size) -> uint64_t {
+                uint64_t value = 0;
+                for (size_t i = 0; i < size; ++i) {
+                    value = (value << 8) | static_cast<unsigned char>(data[i]);
+                }
+                return value;
+            };
+            auto truncated = [this]() {
+                return std::runtime_error((boost::format("Insertion via COPY into %1% failed: Incomplete row in binary format\n")
+                        % m_name).str());
+            };
+            if (end - row < 2) {
+                throw truncated();
+            }
+            const uint64_t field_count = read_uint(row, 2);
+            const char* pos = row + 2;
+            bool found = false;
+            for (uint64_t i = 0; i < field_count; ++i) {
+                if (end - pos < 4) {
+                    throw truncated();
+                }
+                const uint32_t length = static_cast<uint32_t>(read_uint(pos, 4));
+                pos += 4;
+                if (length == 0xffffffff) {
+                    // NULL
+                    continue;
+                }
+                if (static_cast<uint64_t>(end - pos) < length) {
+                    throw truncated();
+                }
+                if (i == m_scheme.key_index() && (length == 8 || length == 4)) {
+                    // sign extension of int4 values
+                    const uint64_t sign = static_cast<uint64_t>(1) << (8 * length - 1);
+                    key = static_cast<osmium::object_id_type>((read_uint(pos, length) ^ sign) - sign);
+                    found = true;
+                }
+                pos += length;
+            }
+            if (!found) {
+                throw std::runtime_error((boost::format("Insertion via COPY into %1% failed: Row has no valid value in column %2%\n")
+                        % m_name % m_scheme.key_column()).str());
+            }
+            return pos;
+        }
+
+    public:
+        /**
+         * \param table_name name of the partitioned table
+         * \param config configuration
+         * \param columns columns of the table
+         */
+        PartitionedTable(const char* table_name, Config& config, Columns columns) :
+            PartitionedTable(table_name, config, columns, [&config](const std::string& name) {
+                return detail::PartitionParent::connect(name.c_str(), config);
+            }) {
+        }
+
+        /**
+         * \param table_name name of the partitioned table
+         * \param config configuration
+         * \param columns columns of the table
+         * \param connect creates the connections of the parent table and of each partition
+         */
+        PartitionedTable(const char* table_name, Config& config, Columns columns, const TransportFactory& connect) :
+            m_name(table_name),
+            m_columns(columns),
+            m_scheme(config, m_columns),
+            m_parent(table_name, config, columns, connect(table_name)),
+            m_partitions(),
+            m_line() {
+            for (size_t i = 0; i < m_scheme.size(); ++i) {
+                const std::string name = PartitionScheme::partition_name(m_name, i);
+                m_partitions.emplace_back(new Table(name.c_str(), config, columns, connect(name)));
+            }
+        }
+
+        const PartitionScheme& scheme() const noexcept {
+            return m_scheme;
+        }
+
+        /**
+         * \brief Get the partitioned table, use it for queries and prepared statements.
+         *
+         * Prepared statements created on it using Table::create_prepared_statement() are pruned to
+         * the matching partition at execution time if they filter by the partition key.
+         */
+        Table& parent() noexcept {
+            return m_parent;
+        }
+
+        /**
+         * \brief Create the standard prepared statements of the table type (e.g. `delete_statement`)
+         * on the partitioned table.
+         *
+         * Statements filtering by the partition key (e.g. `osm_id = $1`) are pruned to one
+         * partition at execution time. Statements filtering by other columns (e.g. `member_id` of
+         * the member tables) scan all partitions. Execute them using parent().
+         */
+        void create_prepared_statements() {
+            m_parent.create_prepared_statements();
+        }
+
+        /**
+         * \brief Get the table of a partition.
+         */
+        Table& partition(const size_t index) {
+            return *m_partitions.at(index);
+        }
+
+        /**
+         * \brief Create the partitioned table and its partitions.
+         */
+        void create_tables() {
+            std::string query = "CREATE TABLE " + m_name + " (";
+            for (auto it = m_columns.begin(); it != m_columns.end(); ++it) {
+                if (it != m_columns.begin()) {
+                    query.append(", ");
+                }
+                query.append("\"" + it->name() + "\" " + it->pg_type());
+            }
+            query.append(") PARTITION BY RANGE (\"" + m_scheme.key_column() + "\")");
+            m_parent.send_query(query.c_str());
+            for (size_t i = 0; i < m_scheme.size(); ++i) {
+                query = "CREATE TABLE " + PartitionScheme::partition_name(m_name, i) + " PARTITION OF " + m_name
+                        + " " + m_scheme.bounds(i);
+                m_parent.send_query(query.c_str());
+            }
+        }
+
+        /**
+         * \brief Create an index on all partitions in parallel.
+         *
+         * Each partition builds its index on its own connection. Finally, the partitioned index on the
+         * parent table is created. PostgreSQL attaches the existing indexes of the partitions to it.
+         *
+         * \param index_name name of the index of the parent table, the partition indexes get the suffix `_p<N>`
+         * \param definition `USING` clause and column list, e.g. `USING btree (osm_id)`
+         *
+         * \throws std::runtime_error if the index of a partition could not be created, after all other
+         * partitions have finished
+         */
+        void create_index(const std::string& index_name, const std::string& definition) {
+            std::exception_ptr error;
+            size_t sent = 0;
+            try {
+                for (; sent < m_partitions.size(); ++sent) {
+                    const std::string query = "CREATE INDEX " + PartitionScheme::partition_name(index_name, sent) + " ON "
+                            + PartitionScheme::partition_name(m_name, sent) + " " + definition;
+                    m_partitions[sent]->send_query_async(query.c_str());
+                }
+            } catch (...) {
+                error = std::current_exception();
+            }
+            // Drain all connections before rethrowing, otherwise they are left in a busy state.
+            for (size_t i = 0; i < sent; ++i) {
+                try {
+                    m_partitions[i]->wait_for_async_query();
+                } catch (...) {
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+            }
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            const std::string query = "CREATE INDEX " + index_name + " ON " + m_name + " " + definition;
+            m_parent.send_query(query.c_str());
+        }
+
+        /**
+         * \brief Start COPY mode on all partitions.
+         *
+         * \param format format of the data passed to send_line()
+         */
+        void start_copy(const CopyFormat format = CopyFormat::TEXT) {
+            m_copy_format = format;
+            for (auto& partition : m_partitions) {
+                partition->start_copy(format);
+            }
+        }
+
+        /**
+         * \brief Send lines to the partitions they belong to.
+         *
+         * \param line line to send; you may send multiple lines at once as one string, separated by \\n.
+         * In binary format, it has to contain complete rows (see BinaryCopyRow).
+         *
+         * \throws std::runtime_error
+         */
+        void send_line(const std::string& line) {
+            if (m_partitions.size() == 1) {
+                m_partitions.front()->send_line(line);
+                return;
+            }
+            const char* begin = line.data();
+            const char* end = begin + line.size();
+            if (m_copy_format == CopyFormat::BINARY) {
+                while (begin != end) {
+                    osmium::object_id_type key;
+                    const char* row_end = binary_key_of(begin, end, key);
+                    m_line.assign(begin, row_end);
+                    m_partitions[m_scheme.partition_of(key)]->send_line(m_line);
+                    begin = row_end;
+                }
+                return;
+            }
+            while (begin != end) {
+                const char* line_end = std::find(begin, end, '\n');
+                if (line_end == end) {
+                    throw std::runtime_error((boost::format("Insertion via COPY into %1% failed: Line does not end with \\n\n%2%")
+                            % m_name % line).str());
+                }
+                const size_t index = m_scheme.partition_of(key_of(begin, line_end));
+                m_line.assign(begin, line_end + 1);
+                m_partitions[index]->send_line(m_line);
+                begin = line_end + 1;
+            }
+        }
+
+        /**
+         * \brief Stop COPY mode on all partitions.
+         */
+        void end_copy() {
+            for (auto& partition : m_partitions) {
+                partition->end_copy();
+            }
+        }
+    };
+}
+
+#endif /* INCLUDE_POSTGRES_DRIVERS_PARTITIONED_TABLE_HPP_ */
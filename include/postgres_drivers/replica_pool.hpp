@@ -0,0 +1,291 @@
+/*
+ * replica_pool.hpp
+ *
+ *  Created on:  2026-10-18
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef INCLUDE_POSTGRES_DRIVERS_REPLICA_POOL_HPP_
+#define INCLUDE_POSTGRES_DRIVERS_REPLICA_POOL_HPP_
+
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/format.hpp>
+#include <libpq-fe.h>
+
+#include "config.hpp"
+
+namespace postgres_drivers {
+
+    namespace detail {
+
+        /**
+         * Skip a string literal, quoted identifier or comment starting at `query`.
+         *
+         * \returns pointer behind it or `query` if there is none
+         */
+        inline const char* skip_quoted(const char* query) {
+            if (*query == '\'' || *query == '"') {
+                const char quote = *query++;
+                while (*query) {
+                    if (*query++ == quote) {
+                        if (*query != quote) {
+                            return query;
+                        }
+                        // doubled quote
+                        ++query;
+                    }
+                }
+                return query;
+            }
+            if (query[0] == '-' && query[1] == '-') {
+                while (*query && *query != '\n') {
+                    ++query;
+                }
+                return query;
+            }
+            if (query[0] == '/' && query[1] == '*') {
+                query += 2;
+                while (*query && !(query[0] == '*' && query[1] == '/')) {
+                    ++query;
+                }
+                return *query ? query + 2 : query;
+            }
+            return query;
+        }
+    }
+
+    /**
+     * \brief Check if a query is a SELECT query which can be sent to a read-only replica.
+     *
+     * The query has to start with `SELECT` or `WITH` (a common table expression). It must not
+     * contain any of the keywords `INSERT`, `UPDATE`, `DELETE`, `MERGE`, `INTO` (`SELECT INTO`),
+     * `SHARE` (locking clauses like `FOR UPDATE` and `FOR SHARE`), `NEXTVAL` and `SETVAL`.
+     * String literals, quoted identifiers and comments are skipped. The check is conservative,
+     * e.g. a query with dollar quoted strings may be treated as a write.
+     */
+    inline bool is_read_only_query(const char* query) {
+        static const char* const rejected[] = {"insert", "update", "delete", "merge", "into", "share", "nextval",
+                "setval"};
+        bool first = true;
+        std::string word;
+        while (*query) {
+            const char* skipped = detail::skip_quoted(query);
+            if (skipped != query) {
+                query = skipped;
+                continue;
+            }
+            const unsigned char c = static_cast<unsigned char>(*query);
+            if (!std::isalpha(c) && c != '_') {
+                ++query;
+                continue;
+            }
+            word.clear();
+            while (std::isalnum(static_cast<unsigned char>(*query)) || *query == '_' || *query == '$') {
+                word.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(*query))));
+                ++query;
+            }
+            if (first) {
+                if (word != "select" && word != "with") {
+                    return false;
+                }
+                first = false;
+            }
+            for (const char* keyword : rejected) {
+                if (word == keyword) {
+                    return false;
+                }
+            }
+        }
+        return !first;
+    }
+
+    /**
+     * \brief Connections to the read-only replicas used by a Table.
+     *
+     * Replicas whose connection fails or whose replication lag exceeds Config::max_replica_lag
+     * are skipped. They are checked again after Config::replica_lag_check_interval seconds.
+     */
+    class ReplicaPool {
+
+        struct Replica {
+            std::string conninfo;
+            PGconn* connection = nullptr;
+            bool healthy = false;
+            bool lagging = false;
+            std::chrono::steady_clock::time_point last_check;
+        };
+
+        struct PreparedStatement {
+            std::string name;
+            std::string query;
+            int params_count;
+        };
+
+        Config& m_config;
+
+        std::vector<Replica> m_replicas;
+
+        /// read-only prepared statements, prepared again after a reconnect
+        std::vector<PreparedStatement> m_statements;
+
+        size_t m_next = 0;
+
+        static bool prepare_on(PGconn* connection, const PreparedStatement& statement) {
+            PGresult* result = PQprepare(connection, statement.name.c_str(), statement.query.c_str(),
+                    statement.params_count, nullptr);
+            const bool ok = PQresultStatus(result) == PGRES_COMMAND_OK;
+            PQclear(result);
+            return ok;
+        }
+
+        /**
+         * Connect (or reconnect) to a replica and prepare all statements.
+         */
+        void connect(Replica& replica) {
+            if (replica.connection) {
+                PQreset(replica.connection);
+            } else {
+                replica.connection = PQconnectdb(replica.conninfo.c_str());
+            }
+            replica.healthy = PQstatus(replica.connection) == CONNECTION_OK;
+            for (const PreparedStatement& statement : m_statements) {
+                if (!replica.healthy) {
+                    break;
+                }
+                replica.healthy = prepare_on(replica.connection, statement);
+            }
+            replica.last_check = std::chrono::steady_clock::now();
+        }
+
+        /**
+         * Get the replication lag of a replica in seconds or a negative value if the query failed.
+         */
+        static double query_lag(PGconn* connection) {
+            PGresult* result = PQexec(connection, "SELECT CASE WHEN NOT pg_is_in_recovery() "
+                    "OR pg_last_wal_receive_lsn() = pg_last_wal_replay_lsn() THEN 0 "
+                    "ELSE COALESCE(EXTRACT(EPOCH FROM now() - pg_last_xact_replay_timestamp()), 0) END");
+            double lag = -1;
+            if (PQresultStatus(result) == PGRES_TUPLES_OK && PQntuples(result) == 1) {
+                lag = std::atof(PQgetvalue(result, 0, 0));
+            }
+            PQclear(result);
+            return lag;
+        }
+
+        /**
+         * Reconnect or check the lag of a replica if the check interval has passed.
+         */
+        void check(Replica& replica) {
+            const auto now = std::chrono::steady_clock::now();
+            if (std::chrono::duration<double>(now - replica.last_check).count() < m_config.replica_lag_check_interval) {
+                return;
+            }
+            if (!replica.healthy) {
+                connect(replica);
+            }
+            if (replica.healthy && m_config.max_replica_lag >= 0) {
+                const double lag = query_lag(replica.connection);
+                replica.healthy = lag >= 0;
+                replica.lagging = lag > m_config.max_replica_lag;
+            }
+            replica.last_check = now;
+        }
+
+        bool usable(const Replica& replica) const noexcept {
+            return replica.healthy && !replica.lagging;
+        }
+
+    public:
+        explicit ReplicaPool(Config& config) :
+            m_config(config),
+            m_replicas(),
+            m_statements() {
+            for (const std::string& conninfo : m_config.replica_conninfos) {
+                m_replicas.emplace_back();
+                m_replicas.back().conninfo = conninfo;
+                connect(m_replicas.back());
+                if (m_replicas.back().healthy && m_config.max_replica_lag >= 0) {
+                    const double lag = query_lag(m_replicas.back().connection);
+                    m_replicas.back().healthy = lag >= 0;
+                    m_replicas.back().lagging = lag > m_config.max_replica_lag;
+                }
+            }
+        }
+
+        ReplicaPool(const ReplicaPool&) = delete;
+
+        ReplicaPool& operator=(const ReplicaPool&) = delete;
+
+        ~ReplicaPool() {
+            for (Replica& replica : m_replicas) {
+                PQfinish(replica.connection);
+            }
+        }
+
+        /**
+         * \brief Create a prepared statement on all replicas.
+         *
+         * \throws std::runtime_error if the statement cannot be prepared on a healthy replica
+         */
+        void create_prepared_statement(const char* name, const std::string& query, const int params_count) {
+            m_statements.push_back(PreparedStatement{name, query, params_count});
+            for (Replica& replica : m_replicas) {
+                if (replica.healthy && !prepare_on(replica.connection, m_statements.back())) {
+                    if (PQstatus(replica.connection) == CONNECTION_OK) {
+                        throw std::runtime_error((boost::format("%1% failed on replica: %2%\n") % query
+                                % PQerrorMessage(replica.connection)).str());
+                    }
+                    replica.healthy = false;
+                }
+            }
+        }
+
+        /**
+         * \brief Choose a replica for a query. The usable replicas are chosen in turn.
+         *
+         * \returns index of the replica or -1 if no replica can be used
+         */
+        int acquire() {
+            for (Replica& replica : m_replicas) {
+                check(replica);
+            }
+            for (size_t i = 0; i < m_replicas.size(); ++i) {
+                const size_t index = (m_next + i) % m_replicas.size();
+                if (usable(m_replicas[index])) {
+                    m_next = index + 1;
+                    return static_cast<int>(index);
+                }
+            }
+            return -1;
+        }
+
+        PGconn* connection(const int index) {
+            return m_replicas.at(index).connection;
+        }
+
+        /**
+         * \brief Return a replica after the query has finished.
+         *
+         * \param index index returned by acquire()
+         *
+         * \returns false if the connection to the replica was lost and the query should be sent to the primary
+         */
+        bool release(const int index) {
+            Replica& replica = m_replicas.at(index);
+            if (PQstatus(replica.connection) != CONNECTION_OK) {
+                replica.healthy = false;
+                replica.last_check = std::chrono::steady_clock::now();
+                return false;
+            }
+            return true;
+        }
+    };
+}
+
+#endif /* INCLUDE_POSTGRES_DRIVERS_REPLICA_POOL_HPP_ */
@@ -0,0 +1,169 @@
+/*
+ * slow_statement_log.hpp
+ *
+ *  Created on:  2026-10-18
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef INCLUDE_POSTGRES_DRIVERS_SLOW_STATEMENT_LOG_HPP_
+#define INCLUDE_POSTGRES_DRIVERS_SLOW_STATEMENT_LOG_HPP_
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <libpq-fe.h>
+
+#include "config.hpp"
+
+namespace postgres_drivers {
+
+    /**
+     * \brief Log of statements which took longer than Config::slow_statement_threshold.
+     *
+     * A fraction (Config::slow_statement_explain_fraction) of the logged statements is executed
+     * a second time with `EXPLAIN (ANALYZE, BUFFERS)` inside a transaction or savepoint which is
+     * rolled back afterwards. The plan is appended to the log entry. Because the first execution
+     * has happened already, statements modifying data might find nothing to modify when they are
+     * explained.
+     */
+    class SlowStatementLog {
+
+        Config& m_config;
+
+        /// Accumulates the explain fraction; a statement is explained whenever it reaches 1.
+        double m_explain_credit = 0.0;
+
+        std::ostream& out() {
+            return m_config.slow_statement_log ? *m_config.slow_statement_log : std::cerr;
+        }
+
+        /**
+         * Execute a command used for the EXPLAIN and report whether it succeeded.
+         */
+        static bool exec_command(PGconn* connection, const char* command) {
+            PGresult* result = PQexec(connection, command);
+            const bool ok = PQresultStatus(result) == PGRES_COMMAND_OK;
+            PQclear(result);
+            return ok;
+        }
+
+        /**
+         * Execute `EXPLAIN (ANALYZE, BUFFERS)` and write the plan to the log.
+         */
+        void explain(PGconn* connection, const bool in_transaction, const std::string& explain_query) {
+            const char* begin = in_transaction ? "SAVEPOINT postgres_drivers_explain" : "BEGIN";
+            const char* rollback = in_transaction ? "ROLLBACK TO SAVEPOINT postgres_drivers_explain" : "ROLLBACK";
+            if (!exec_command(connection, begin)) {
+                out() << "  EXPLAIN failed: " << PQerrorMessage(connection);
+                return;
+            }
+            PGresult* result = PQexec(connection, explain_query.c_str());
+            if (PQresultStatus(result) == PGRES_TUPLES_OK) {
+                out() << "  plan:\n";
+                for (int i = 0; i < PQntuples(result); ++i) {
+                    out() << "    " << PQgetvalue(result, i, 0) << '\n';
+                }
+            } else {
+                out() << "  EXPLAIN failed: " << PQerrorMessage(connection);
+            }
+            PQclear(result);
+            exec_command(connection, rollback);
+            if (in_transaction) {
+                exec_command(connection, "RELEASE SAVEPOINT postgres_drivers_explain");
+            }
+        }
+
+        bool sample_explain() {
+            m_explain_credit += m_config.slow_statement_explain_fraction;
+            if (m_explain_credit >= 1.0) {
+                m_explain_credit -= 1.0;
+                return true;
+            }
+            return false;
+        }
+
+    public:
+        explicit SlowStatementLog(Config& config) :
+            m_config(config) {
+        }
+
+        /**
+         * \brief Is the log enabled?
+         */
+        bool enabled() const noexcept {
+            return m_config.slow_statement_threshold >= 0;
+        }
+
+        /**
+         * \brief Log a prepared statement if it was slow.
+         *
+         * \param connection database connection the statement was executed on
+         * \param in_transaction true if the connection is inside a `BEGIN` `COMMIT` block
+         * \param table_name name of the table (used in the log only)
+         * \param name name of the prepared statement
+         * \param query query of the prepared statement
+         * \param params_count number of parameters
+         * \param param_values parameters in text format
+         * \param nanoseconds duration of the execution
+         */
+        void log_prepared(PGconn* connection, const bool in_transaction, const std::string& table_name,
+                const char* name, const std::string& query, const int params_count,
+                const char* const* param_values, const uint64_t nanoseconds) {
+            if (nanoseconds < m_config.slow_statement_threshold * 1000000) {
+                return;
+            }
+            out() << "slow statement on table " << table_name << " (" << nanoseconds / 1000000.0 << " ms): "
+                    << name << ": " << query << "\n  parameters:";
+            std::string explain_query = "EXPLAIN (ANALYZE, BUFFERS) EXECUTE ";
+            explain_query.append(name);
+            for (int i = 0; i < params_count; ++i) {
+                explain_query.append(i == 0 ? "(" : ", ");
+                if (!param_values[i]) {
+                    out() << " $" << (i + 1) << "=NULL";
+                    explain_query.append("NULL");
+                    continue;
+                }
+                out() << " $" << (i + 1) << "='" << param_values[i] << "'";
+                char* literal = PQescapeLiteral(connection, param_values[i], strlen(param_values[i]));
+                if (literal) {
+                    explain_query.append(literal);
+                    PQfreemem(literal);
+                }
+            }
+            if (params_count > 0) {
+                explain_query.push_back(')');
+            }
+            out() << '\n';
+            if (sample_explain()) {
+                explain(connection, in_transaction, explain_query);
+            }
+            out().flush();
+        }
+
+        /**
+         * \brief Log an ad-hoc query if it was slow.
+         *
+         * \param connection database connection the statement was executed on
+         * \param in_transaction true if the connection is inside a `BEGIN` `COMMIT` block
+         * \param table_name name of the table (used in the log only)
+         * \param query SQL query
+         * \param nanoseconds duration of the execution
+         */
+        void log_query(PGconn* connection, const bool in_transaction, const std::string& table_name,
+                const char* query, const uint64_t nanoseconds) {
+            if (nanoseconds < m_config.slow_statement_threshold * 1000000) {
+                return;
+            }
+            out() << "slow statement on table " << table_name << " (" << nanoseconds / 1000000.0 << " ms): "
+                    << query << '\n';
+            if (sample_explain()) {
+                explain(connection, in_transaction, std::string{"EXPLAIN (ANALYZE, BUFFERS) "} + query);
+            }
+            out().flush();
+        }
+    };
+}
+
+#endif /* INCLUDE_POSTGRES_DRIVERS_SLOW_STATEMENT_LOG_HPP_ */
@@ -10,9 +10,32 @@
 
 #include <libpq-fe.h>
 #include <boost/format.hpp>
+#include "adaptive_flush.hpp"
+#include "binary_copy.hpp"
 #include "columns.hpp"
+#include "copy_sink.hpp"
+#include "lookup_cache.hpp"
+#include "memory_budget.hpp"
+#include "replica_pool.hpp"
+#include "slow_statement_log.hpp"
+#include "table_stats.hpp"
+#include "tile_query.hpp"
+#include "transport.hpp"
+#include "transport_recording.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <sstream>
+#include <vector>
+#include <osmium/osm/location.hpp>
 #include <osmium/osm/types.hpp>
+#include <poll.h>
 #include <string.h>
 #include <boost/iostreams/device/file.hpp>
 #include <boost/iostreams/stream.hpp>
@@ -63,6 +86,11 @@ namespace postgres_drivers {
          */
         bool m_copy_mode = false;
 
+        /**
+         * format of the current COPY
+         */
+        CopyFormat m_copy_format = CopyFormat::TEXT;
+
         /**
          * track if a BEGIN COMMIT block has been opened
          */
@@ -74,14 +102,420 @@ namespace postgres_drivers {
          * connection to database
          *
          * This pointer is a nullpointer if this table is used in demo mode (for testing purposes).
+         * In demo mode, data sent using COPY is discarded.
+         */
+        std::unique_ptr<Transport> m_transport;
+
+        /**
+         * destination of COPY data if the table has no database connection, e.g. a CopyDumpSink
+         *
+         * This pointer is a nullpointer in production and demo mode.
          */
-        PGconn *m_database_connection;
+        std::unique_ptr<CopySink> m_sink;
 
         /**
-         * maximum size of copy buffer
+         * default size of the client side copy buffer, see Config::copy_buffer_size
          */
         static const int BUFFER_SEND_SIZE = 10000;
 
+        /**
+         * controller of the COPY buffer size, only used if Config::adaptive_copy_buffer is true
+         */
+        std::unique_ptr<AdaptiveFlushSize> m_flush_size;
+
+        /**
+         * track if libpq could not send all COPY data without blocking
+         */
+        bool m_flush_pending = false;
+
+        /**
+         * COPY data which has not been passed to libpq yet
+         */
+        std::string m_copy_buffer;
+
+        /**
+         * Protects #m_copy_buffer, #m_copy_mode, the connection in COPY mode and the COPY statistics if
+         * a memory budget is used because the budget may flush the buffer from another thread.
+         */
+        std::mutex m_copy_mutex;
+
+        /**
+         * track if this table is registered at Config::memory_budget
+         */
+        bool m_budget_registered = false;
+
+        /**
+         * ID of this table at Config::memory_budget
+         */
+        size_t m_budget_consumer = 0;
+
+        /**
+         * memory usage last reported to Config::memory_budget
+         */
+        size_t m_budget_usage = 0;
+
+        /**
+         * error which occurred while the memory budget flushed the buffer from another thread, it is
+         * rethrown by the next call of send_line() or end_copy()
+         */
+        std::exception_ptr m_budget_error;
+
+        /**
+         * cache of get_location() lookups, only used by POINT and UNTAGGED_POINT tables
+         *
+         * This pointer is a nullpointer if caching is disabled.
+         */
+        std::unique_ptr<LookupCache<osmium::Location>> m_location_cache;
+
+        /**
+         * cache of get_way_ids() lookups, only used by NODE_WAYS tables
+         *
+         * This pointer is a nullpointer if caching is disabled.
+         */
+        std::unique_ptr<LookupCache<std::vector<osmium::object_id_type>>> m_way_ids_cache;
+
+        /**
+         * position of the column holding the key of the lookup cache in the COPY data, -1 if there
+         * is no cache
+         */
+        int m_cache_key_column = -1;
+
+        /**
+         * performance counters, only updated if Config::collect_stats is true
+         */
+        TableStats m_stats;
+
+        /**
+         * log of slow statements, only used if Config::slow_statement_threshold is not negative
+         */
+        SlowStatementLog m_slow_log;
+
+        /**
+         * queries of the prepared statements of this table, indexed by their name
+         */
+        std::map<std::string, std::string> m_prepared_statements;
+
+        /**
+         * connections to the read-only replicas, only used if Config::replica_conninfos is not empty
+         */
+        std::unique_ptr<ReplicaPool> m_replicas;
+
+        /**
+         * names of the prepared statements which are executed on the replicas
+         */
+        std::set<std::string> m_read_only_statements;
+
+        /**
+         * Has this table written to the primary? Reads are pinned to the primary after a write,
+         * see Config::replica_pin_after_write.
+         */
+        bool m_written = false;
+
+        /**
+         * time of the last write to the primary
+         */
+        std::chrono::steady_clock::time_point m_last_write;
+
+        /**
+         * register this table at the memory budget
+         */
+        void register_budget() {
+            if (m_config.memory_budget) {
+                m_budget_consumer = m_config.memory_budget->add_consumer([this]() {
+                    release_copy_buffer();
+                });
+                m_budget_registered = true;
+            }
+        }
+
+        /**
+         * Unregister this table from the memory budget. Waits until a release of the COPY buffer by
+         * another thread has finished.
+         *
+         * \returns this table (for use in member initializer lists)
+         */
+        Table& unregister_budget() {
+            if (m_budget_registered) {
+                m_config.memory_budget->remove_consumer(m_budget_consumer);
+                m_budget_registered = false;
+            }
+            return *this;
+        }
+
+        /**
+         * Flush and free the COPY buffer on request of the memory budget, possibly called by another
+         * thread. Errors are stored and rethrown in the thread owning this table.
+         */
+        void release_copy_buffer() {
+            {
+                std::lock_guard<std::mutex> lock{m_copy_mutex};
+                try {
+                    if (m_copy_mode && !m_budget_error) {
+                        put_copy_buffer();
+                    }
+                } catch (...) {
+                    m_budget_error = std::current_exception();
+                }
+                if (!m_copy_buffer.empty() || m_budget_usage == 0) {
+                    return;
+                }
+                std::string().swap(m_copy_buffer);
+                m_budget_usage = 0;
+            }
+            report_budget_usage(0);
+        }
+
+        /**
+         * Report the growth of the COPY buffer needed to append `size` bytes to the memory budget
+         * before the memory is allocated. The budget blocks if the hard limit is exceeded.
+         */
+        void reserve_budget(const size_t size) {
+            size_t usage;
+            {
+                std::lock_guard<std::mutex> lock{m_copy_mutex};
+                const size_t required = m_copy_buffer.size() + size;
+                if (required <= m_copy_buffer.capacity() || required <= m_budget_usage) {
+                    return;
+                }
+                // grow like std::string does
+                usage = m_budget_usage = std::max(required, 2 * m_copy_buffer.capacity());
+            }
+            report_budget_usage(usage);
+        }
+
+        /**
+         * Rethrow an error which occurred while the memory budget flushed the COPY buffer. The
+         * caller has to lock #m_copy_mutex if a memory budget is used.
+         */
+        void check_budget_error() {
+            if (m_budget_error) {
+                std::exception_ptr error = m_budget_error;
+                m_budget_error = nullptr;
+                std::rethrow_exception(error);
+            }
+        }
+
+        size_t copy_buffer_limit() const noexcept {
+            if (m_flush_size) {
+                return m_flush_size->size();
+            }
+            return m_config.copy_buffer_size == 0 ? BUFFER_SEND_SIZE : m_config.copy_buffer_size;
+        }
+
+        /**
+         * Wait until the socket of the connection is writable. Data sent by the server (e.g. an error)
+         * is consumed meanwhile.
+         *
+         * \returns waiting time in nanoseconds
+         */
+        uint64_t wait_for_socket() {
+            StatsTimer timer{true};
+            pollfd fd;
+            fd.fd = m_transport->socket();
+            fd.events = POLLOUT | POLLIN;
+            fd.revents = 0;
+            while (poll(&fd, 1, -1) < 0) {
+                if (errno != EINTR) {
+                    throw std::runtime_error((boost::format("Waiting for the connection of %1% failed: %2%\n")
+                            % m_name % strerror(errno)).str());
+                }
+            }
+            if ((fd.revents & POLLIN) && m_transport->consume_input() != 1) {
+                throw std::runtime_error((boost::format("Insertion via COPY into %1% failed: %2%\n") % m_name
+                        % m_transport->error_message()).str());
+            }
+            return timer.elapsed();
+        }
+
+        /**
+         * Send all data buffered by libpq (nonblocking mode).
+         *
+         * \returns time spent waiting for the socket in nanoseconds
+         */
+        uint64_t finish_pending_flush() {
+            uint64_t stall_time = 0;
+            int result;
+            while (m_flush_pending && (result = m_transport->flush()) != 0) {
+                if (result < 0) {
+                    throw std::runtime_error((boost::format("Insertion via COPY into %1% failed: %2%\n") % m_name
+                            % m_transport->error_message()).str());
+                }
+                stall_time += wait_for_socket();
+                if (m_config.collect_stats) {
+                    ++m_stats.stalls;
+                }
+            }
+            m_flush_pending = false;
+            return stall_time;
+        }
+
+        /**
+         * Pass the COPY buffer to libpq in nonblocking mode. The previous buffer is sent while the
+         * producer fills the next one. Only if it has not been sent completely yet, this method waits.
+         */
+        void put_copy_buffer_nonblocking() {
+            uint64_t stall_time = finish_pending_flush();
+            int result;
+            while ((result = m_transport->put_copy_data(m_copy_buffer.data(), static_cast<int>(m_copy_buffer.size()))) == 0) {
+                stall_time += wait_for_socket();
+            }
+            if (result < 0 || (result = m_transport->flush()) < 0) {
+                throw std::runtime_error((boost::format("Insertion via COPY into %1% failed: %2%\n") % m_name
+                        % m_transport->error_message()).str());
+            }
+            m_flush_pending = result == 1;
+            m_flush_size->record(m_copy_buffer.size(), stall_time);
+            if (m_config.collect_stats) {
+                m_stats.copy_buffer_size = m_flush_size->size();
+                m_stats.copy_buffer_adjustments = m_flush_size->adjustments();
+                m_stats.would_block += m_flush_pending;
+                m_stats.stall_time += stall_time;
+            }
+        }
+
+        /**
+         * Pass the COPY buffer to libpq. The caller has to lock #m_copy_mutex if a memory budget is used.
+         */
+        void put_copy_buffer() {
+            if (m_copy_buffer.empty()) {
+                return;
+            }
+            if (m_sink) {
+                m_sink->write(m_copy_buffer.data(), m_copy_buffer.size());
+            } else if (m_flush_size && m_transport) {
+                put_copy_buffer_nonblocking();
+            } else if (m_transport && m_transport->put_copy_data(m_copy_buffer.data(), static_cast<int>(m_copy_buffer.size())) != 1) {
+                throw std::runtime_error((boost::format("Insertion via COPY into %1% failed: %2%\n") % m_name
+                        % m_transport->error_message()).str());
+            }
+            m_copy_buffer.clear();
+            if (m_config.collect_stats) {
+                ++m_stats.flushes;
+            }
+        }
+
+        /**
+         * Report a changed memory usage to the memory budget. Must not be called with #m_copy_mutex locked.
+         */
+        void report_budget_usage(const size_t usage) {
+            if (m_budget_registered) {
+                m_config.memory_budget->update(m_budget_consumer, usage);
+            }
+        }
+
+        /**
+         * \brief Choose the replica a read-only query is sent to.
+         *
+         * \returns index of the replica or -1 if the query has to be sent to the primary
+         */
+        int acquire_replica() {
+            if (!m_replicas || m_begin) {
+                return -1;
+            }
+            if (m_written && (m_config.replica_pin_after_write < 0 || std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - m_last_write).count() < m_config.replica_pin_after_write)) {
+                return -1;
+            }
+            return m_replicas->acquire();
+        }
+
+        /**
+         * Remember that data has been written to the primary.
+         */
+        void mark_written() {
+            if (m_replicas) {
+                m_written = true;
+                m_last_write = std::chrono::steady_clock::now();
+            }
+        }
+
+        /**
+         * create the lookup caches if they are enabled and useful for the type of this table
+         */
+        void init_caches() {
+            if (m_config.lookup_cache_memory == 0) {
+                return;
+            }
+            const TableType type = m_columns.get_type();
+            if (type == TableType::POINT || type == TableType::UNTAGGED_POINT) {
+                m_location_cache.reset(new LookupCache<osmium::Location>(
+                        LookupCache<osmium::Location>::with_memory_limit(m_config.lookup_cache_memory)));
+            } else if (type == TableType::NODE_WAYS) {
+                // Most nodes are member of one or two ways.
+                m_way_ids_cache.reset(new LookupCache<std::vector<osmium::object_id_type>>(
+                        LookupCache<std::vector<osmium::object_id_type>>::with_memory_limit(m_config.lookup_cache_memory,
+                        2 * sizeof(osmium::object_id_type))));
+            } else {
+                return;
+            }
+            const ColumnClass key_class = type == TableType::NODE_WAYS ? ColumnClass::NODE_ID : ColumnClass::OSM_ID;
+            int position = 0;
+            for (ColumnsIterator it = m_columns.begin(); it != m_columns.end(); ++it, ++position) {
+                if (it->column_class() == key_class) {
+                    m_cache_key_column = position;
+                    break;
+                }
+            }
+        }
+
+        /**
+         * Invalidate the cached lookups of the rows in COPY data (see send_line()).
+         */
+        void invalidate_copied_keys(const std::string& data) {
+            if (m_copy_format == CopyFormat::TEXT) {
+                size_t row_begin = 0;
+                while (row_begin < data.size()) {
+                    size_t field_begin = row_begin;
+                    for (int i = 0; i < m_cache_key_column && field_begin != std::string::npos; ++i) {
+                        field_begin = data.find('\t', field_begin);
+                        if (field_begin != std::string::npos) {
+                            ++field_begin;
+                        }
+                    }
+                    if (field_begin != std::string::npos && data.compare(field_begin, 2, "\\N") != 0) {
+                        invalidate_cache_key(strtoll(data.c_str() + field_begin, nullptr, 10));
+                    }
+                    row_begin = data.find('\n', row_begin);
+                    if (row_begin == std::string::npos) {
+                        break;
+                    }
+                    ++row_begin;
+                }
+                return;
+            }
+            // binary format: field count (int16), then length (int32, -1 for NULL) and value of each field
+            auto read_int = [&data](const size_t pos, const size_t size) -> int64_t {
+                uint64_t value = 0;
+                for (size_t i = 0; i < size; ++i) {
+                    value = (value << 8) | static_cast<unsigned char>(data[pos + i]);
+                }
+                // sign extension of narrow values
+                const uint64_t sign = static_cast<uint64_t>(1) << (8 * size - 1);
+                return static_cast<int64_t>((value ^ sign) - sign);
+            };
+            size_t pos = 0;
+            while (pos + 2 <= data.size()) {
+                const int64_t field_count = read_int(pos, 2);
+                pos += 2;
+                for (int64_t i = 0; i < field_count && pos + 4 <= data.size(); ++i) {
+                    const int64_t length = read_int(pos, 4);
+                    pos += 4;
+                    if (length < 0) {
+                        continue;
+                    }
+                    if (i == m_cache_key_column && (length == 8 || length == 4) && pos + length <= data.size()) {
+                        invalidate_cache_key(read_int(pos, length));
+                    }
+                    pos += length;
+                }
+            }
+        }
+
+        void invalidate_cache_key(const osmium::object_id_type id) {
+            invalidate_location(id);
+            invalidate_way_ids(id);
+        }
+
         /**
          * create all necessary prepared statements for this table
          *
@@ -101,6 +535,8 @@ namespace postgres_drivers {
             } else if (m_columns.get_type() == TableType::UNTAGGED_POINT) {
                 query = (boost::format("SELECT x, y FROM %1% WHERE osm_id = $1") % m_name).str();
                 create_prepared_statement("get_location_from_untagged_nodes_table", query, 1);
+                query = (boost::format("INSERT INTO %1% (osm_id, x, y) VALUES ($1, $2, $3)") % m_name).str();
+                create_prepared_statement("insert_untagged_node", query, 3);
             } else if (m_columns.get_type() == TableType::WAYS_LINEAR) {
                 query = (boost::format("SELECT geom FROM %1% WHERE osm_id = $1") % m_name).str();
                 create_prepared_statement("get_linestring", query, 1);
@@ -111,7 +547,7 @@ namespace postgres_drivers {
                 create_prepared_statement("get_way_ids", query, 1);
                 query = (boost::format("SELECT node_id, position FROM %1% WHERE way_id = $1") % m_name).str();
                 create_prepared_statement("get_nodes", query, 1);
-                query = (boost::format("DELETE FROM %1% WHERE way_id = $1") % m_name).str();
+                query = (boost::format("DELETE FROM %1% WHERE way_id = $1 RETURNING node_id") % m_name).str();
                 create_prepared_statement("delete_way_node_list", query, 1);
             } else if (m_columns.get_type() == TableType::RELATION_MEMBER_NODES
                     || m_columns.get_type() == TableType::RELATION_MEMBER_WAYS
@@ -140,6 +576,28 @@ namespace postgres_drivers {
          */
         int get_geometry_column_id();
 
+        /**
+         * Are statements timed (for the statistics or the log of slow statements)?
+         */
+        bool timing_enabled() const {
+            return m_config.collect_stats || m_slow_log.enabled();
+        }
+
+        /**
+         * Add the duration of a statement to the statistics if statistics are enabled.
+         */
+        void record_statement(const char* name, const uint64_t nanoseconds, const bool error) {
+            if (!m_config.collect_stats) {
+                return;
+            }
+            StatementStats& stats = m_stats.statements[name];
+            ++stats.calls;
+            if (error) {
+                ++stats.errors;
+            }
+            stats.latency.record(nanoseconds);
+        }
+
         /**
          * For the status of the query result and throw an exception if necessary.
          *
@@ -154,7 +612,7 @@ namespace postgres_drivers {
         void check_and_free_result(PGresult* result, ExecStatusType expected_status, const std::string& query) {
             std::string message;
             if (PQresultStatus(result) != expected_status) {
-                message = PQerrorMessage(m_database_connection);
+                message = m_transport->error_message();
                 PQclear(result);
             }
             if (!result || PQresultStatus(result) != expected_status) {
@@ -163,18 +621,69 @@ namespace postgres_drivers {
             PQclear(result);
         }
 
+        /**
+         * Connect to the database as configured (see Config::primary_conninfo, Config::transport_record_dir
+         * and Config::transport_replay_dir).
+         */
+        static std::unique_ptr<Transport> connect(const char* table_name, const Config& config) {
+            if (!config.transport_replay_dir.empty()) {
+                const std::string path = (boost::format("%1%/%2%.transport") % config.transport_replay_dir % table_name).str();
+                return std::unique_ptr<Transport>{new ReplayTransport(path, config.replay_latency_factor,
+                        static_cast<uint64_t>(config.replay_added_latency * 1000000))};
+            }
+            std::string connection_params = config.primary_conninfo;
+            if (connection_params.empty()) {
+                connection_params = "dbname=";
+                connection_params.append(config.m_database_name);
+            }
+            std::unique_ptr<LibpqTransport> transport{new LibpqTransport(connection_params.c_str())};
+            if (!transport->connected()) {
+                throw std::runtime_error((boost::format("Cannot establish connection to database: %1%\n")
+                    %  transport->error_message()).str());
+            }
+            if (!config.transport_record_dir.empty()) {
+                const std::string path = (boost::format("%1%/%2%.transport") % config.transport_record_dir % table_name).str();
+                return std::unique_ptr<Transport>{new RecordingTransport(std::move(transport), path)};
+            }
+            return std::unique_ptr<Transport>{transport.release()};
+        }
+
     public:
         Table() = delete;
 
         Table(const Table&) = delete;
 
         Table(Table&& other) :
-            m_name(std::move(other.m_name)),
+            // The budget calls back the table at its address and may do so from another thread.
+            // Unregister the old one before any member is moved.
+            m_name(std::move(other.unregister_budget().m_name)),
             m_config(other.m_config),
             m_copy_mode(other.m_copy_mode),
+            m_copy_format(other.m_copy_format),
             m_begin(other.m_begin),
             m_columns(std::move(other.m_columns)),
-            m_database_connection(other.m_database_connection) {
+            m_transport(std::move(other.m_transport)),
+            m_sink(std::move(other.m_sink)),
+            m_flush_size(std::move(other.m_flush_size)),
+            m_flush_pending(other.m_flush_pending),
+            m_location_cache(std::move(other.m_location_cache)),
+            m_way_ids_cache(std::move(other.m_way_ids_cache)),
+            m_cache_key_column(other.m_cache_key_column),
+            m_stats(std::move(other.m_stats)),
+            m_slow_log(other.m_config),
+            m_prepared_statements(std::move(other.m_prepared_statements)),
+            m_replicas(std::move(other.m_replicas)),
+            m_read_only_statements(std::move(other.m_read_only_statements)),
+            m_written(other.m_written),
+            m_last_write(other.m_last_write) {
+            m_copy_buffer = std::move(other.m_copy_buffer);
+            other.m_copy_buffer.clear();
+            m_budget_usage = other.m_budget_usage;
+            other.m_budget_usage = 0;
+            m_budget_error = other.m_budget_error;
+            other.m_budget_error = nullptr;
+            register_budget();
+            report_budget_usage(m_budget_usage);
         }
 
         /**
@@ -182,27 +691,71 @@ namespace postgres_drivers {
          */
         /// \todo replace const char* by std::string&
         Table(const char* table_name, Config& config, Columns columns) :
+                Table(table_name, config, columns, connect(table_name, config)) {
+        }
+
+        /**
+         * constructor using a custom transport, e.g. a ReplayTransport
+         *
+         * Read-only replicas are only used if the transport supports them (see
+         * Transport::supports_replicas()) because queries sent to the replicas bypass the transport.
+         *
+         * \param table_name name of the table
+         * \param config configuration
+         * \param columns columns of the table
+         * \param transport connection to the database
+         */
+        Table(const char* table_name, Config& config, Columns columns, std::unique_ptr<Transport> transport) :
                 m_name(table_name),
                 m_config(config),
                 m_copy_mode(false),
-                m_columns(columns) {
-            std::string connection_params = "dbname=";
-            connection_params.append(m_config.m_database_name);
-            m_database_connection = PQconnectdb(connection_params.c_str());
-            if (PQstatus(m_database_connection) != CONNECTION_OK) {
-                throw std::runtime_error((boost::format("Cannot establish connection to database: %1%\n")
-                    %  PQerrorMessage(m_database_connection)).str());
+                m_columns(columns),
+                m_transport(std::move(transport)),
+                m_slow_log(config) {
+            if (!m_config.replica_conninfos.empty() && m_transport && m_transport->supports_replicas()) {
+                m_replicas.reset(new ReplicaPool(m_config));
+            }
+            init_caches();
+            register_budget();
+            if (m_config.adaptive_copy_buffer) {
+                m_flush_size.reset(new AdaptiveFlushSize(m_config.copy_buffer_min_size, m_config.copy_buffer_max_size,
+                        m_config.copy_buffer_size == 0 ? BUFFER_SEND_SIZE : m_config.copy_buffer_size));
             }
         }
 
+        /**
+         * constructor for offline dumps, does not establish a database connection
+         *
+         * COPY data is written to the sink. All other queries are ignored like in demo mode.
+         *
+         * \param table_name name of the table
+         * \param config configuration
+         * \param columns columns of the table
+         * \param sink destination of COPY data, e.g. a CopyDumpSink
+         */
+        Table(const char* table_name, Config& config, Columns columns, std::unique_ptr<CopySink> sink) :
+                m_name(table_name),
+                m_config(config),
+                m_copy_mode(false),
+                m_columns(columns),
+                m_sink(std::move(sink)),
+                m_slow_log(config) {
+            register_budget();
+        }
+
         /**
          * constructor for testing, does not establishes database connection
+         *
+         * COPY works but all data is discarded (null sink). Use this for benchmarks of client side code.
          */
         Table(Columns& columns, Config& config) :
                 m_name(""),
                 m_config(config),
                 m_copy_mode(false),
-                m_columns(columns) { }
+                m_columns(columns),
+                m_slow_log(config) {
+            register_budget();
+        }
 
         ~Table() {
             if (m_name != "") {
@@ -212,24 +765,36 @@ namespace postgres_drivers {
                 if (m_begin) {
                     commit();
                 }
-                PQfinish(m_database_connection);
             }
+            unregister_budget();
         }
 
         /**
          * \brief create a prepared statement
          *
+         * SELECT statements are prepared on the read-only replicas, too.
+         *
          * \param name name of the prepared statement
          * \param query template query of this statement
          * \param params_count number of argument of this query
          */
         void create_prepared_statement(const char* name, std::string query, int params_count) {
-            PGresult *result = PQprepare(m_database_connection, name, query.c_str(), params_count, NULL);
+            if (!m_transport) {
+                // demo mode or offline dump
+                m_prepared_statements[name] = query;
+                return;
+            }
+            PGresult *result = m_transport->prepare(name, query.c_str(), params_count);
             if (PQresultStatus(result) != PGRES_COMMAND_OK) {
                 PQclear(result);
-                throw std::runtime_error((boost::format("%1% failed: %2%\n") % query % PQerrorMessage(m_database_connection)).str());
+                throw std::runtime_error((boost::format("%1% failed: %2%\n") % query % m_transport->error_message()).str());
             }
             PQclear(result);
+            m_prepared_statements[name] = query;
+            if (m_replicas && is_read_only_query(query.c_str())) {
+                m_replicas->create_prepared_statement(name, query, params_count);
+                m_read_only_statements.insert(name);
+            }
         }
 
         /**
@@ -260,22 +825,89 @@ namespace postgres_drivers {
          * \brief Send a line to the database (it will get it from STDIN) during copy mode.
          *
          * This method asserts that the database connection is in COPY mode when this method is called.
+         * Lines are collected in a client side buffer which is passed to libpq when it reaches
+         * Config::copy_buffer_size bytes. In demo mode, the buffer is discarded instead.
          *
          * \param line line to send; you may send multiple lines at once as one string, separated by \\n.
+         * In binary format, it has to contain complete rows (see BinaryCopyRow).
          *
          * \throws std::runtime_error
          */
         void send_line(const std::string& line) {
-            assert(m_database_connection);
             if (!m_copy_mode) {
                 throw std::runtime_error((boost::format("Insertion via COPY \"%1%\" failed: You are not in COPY mode!\n") % line).str());
             }
-            if (line[line.size()-1] != '\n') {
+            if (m_copy_format == CopyFormat::TEXT && line[line.size()-1] != '\n') {
                 throw std::runtime_error((boost::format("Insertion via COPY into %1% failed: Line does not end with \\n\n%2%") % m_name % line).str());
             }
-            if (PQputCopyData(m_database_connection, line.c_str(), line.size()) != 1) {
-                throw std::runtime_error((boost::format("Insertion via COPY \"%1%\" failed: %2%\n") % line % PQerrorMessage(m_database_connection)).str());
+            if (m_cache_key_column >= 0) {
+                // New rows replace cached locations or add ways to the cached lists of nodes.
+                invalidate_copied_keys(line);
+            }
+            if (m_budget_registered) {
+                reserve_budget(line.size());
+            }
+            bool usage_changed = false;
+            size_t usage = 0;
+            {
+                std::unique_lock<std::mutex> lock{m_copy_mutex, std::defer_lock};
+                if (m_budget_registered) {
+                    lock.lock();
+                    check_budget_error();
+                    if (m_copy_buffer.capacity() < m_budget_usage) {
+                        m_copy_buffer.reserve(m_budget_usage);
+                    }
+                }
+                m_copy_buffer.append(line);
+                if (m_copy_buffer.size() >= copy_buffer_limit()) {
+                    put_copy_buffer();
+                }
+                if (m_config.collect_stats) {
+                    if (m_copy_format == CopyFormat::TEXT) {
+                        m_stats.rows += std::count(line.begin(), line.end(), '\n');
+                    } else {
+                        m_stats.rows += count_binary_copy_rows(line.data(), line.size());
+                    }
+                    m_stats.bytes += line.size();
+                }
+                if (m_budget_registered && m_copy_buffer.capacity() != m_budget_usage) {
+                    usage = m_budget_usage = m_copy_buffer.capacity();
+                    usage_changed = true;
+                }
+            }
+            if (usage_changed) {
+                report_budget_usage(usage);
+            }
+        }
+
+        /**
+         * \brief Pass the client side COPY buffer to libpq.
+         *
+         * This method is thread-safe if a memory budget is used.
+         *
+         * \param release free the memory of the buffer
+         *
+         * \throws std::runtime_error
+         */
+        void flush_copy_buffer(const bool release = false) {
+            size_t usage;
+            {
+                std::unique_lock<std::mutex> lock{m_copy_mutex, std::defer_lock};
+                if (m_budget_registered) {
+                    lock.lock();
+                    check_budget_error();
+                }
+                put_copy_buffer();
+                if (release) {
+                    std::string().swap(m_copy_buffer);
+                }
+                usage = m_copy_buffer.capacity();
+                if (usage == m_budget_usage) {
+                    return;
+                }
+                m_budget_usage = usage;
             }
+            report_budget_usage(usage);
         }
 
         /**
@@ -290,10 +922,12 @@ namespace postgres_drivers {
          *
          * Additionally, this method sets #m_copy_mode to `true`.
          *
+         * \param format format of the data passed to send_line(); the header of the binary format is
+         * sent by this method
+         *
          * \throws std::runtime_error
          */
-        void start_copy() {
-            assert(m_database_connection);
+        void start_copy(const CopyFormat format = CopyFormat::TEXT) {
             std::string copy_command = "COPY ";
             copy_command.append(m_name);
             copy_command.append(" (");
@@ -304,9 +938,33 @@ namespace postgres_drivers {
             }
             copy_command.pop_back();
             copy_command.append(") FROM STDIN");
-            PGresult *result = PQexec(m_database_connection, copy_command.c_str());
-            check_and_free_result(result, PGRES_COPY_IN, copy_command);
+            if (format == CopyFormat::BINARY) {
+                copy_command.append(" (FORMAT binary)");
+            }
+            std::unique_lock<std::mutex> lock{m_copy_mutex, std::defer_lock};
+            if (m_budget_registered) {
+                lock.lock();
+            }
+            if (!m_transport) {
+                // demo mode or offline dump
+                if (m_sink) {
+                    m_sink->start(copy_command, format);
+                }
+            } else {
+                PGresult *result = m_transport->exec(copy_command.c_str());
+                check_and_free_result(result, PGRES_COPY_IN, copy_command);
+                if (m_flush_size) {
+                    if (m_transport->set_nonblocking(true) != 0) {
+                        throw std::runtime_error(m_transport->error_message());
+                    }
+                    m_flush_size->restart();
+                }
+            }
             m_copy_mode = true;
+            m_copy_format = format;
+            if (format == CopyFormat::BINARY) {
+                m_copy_buffer.append(binary_copy_header());
+            }
         }
 
         /**
@@ -321,17 +979,57 @@ namespace postgres_drivers {
                 // This allows us to call this method even if we are not in copy mode as a measure of safety.
                 return;
             }
-            assert(m_database_connection);
-            if (PQputCopyEnd(m_database_connection, nullptr) != 1) {
-                throw std::runtime_error(PQerrorMessage(m_database_connection));
+            // The lock keeps the memory budget from using the connection while COPY is ended.
+            std::unique_lock<std::mutex> lock{m_copy_mutex, std::defer_lock};
+            if (m_budget_registered) {
+                lock.lock();
+                check_budget_error();
             }
-            PGresult *result = PQgetResult(m_database_connection);
-            if (PQresultStatus(result) != PGRES_COMMAND_OK) {
-                throw std::runtime_error((boost::format("COPY END command failed: %1%\n") %  PQerrorMessage(m_database_connection)).str());
+            if (m_copy_format == CopyFormat::BINARY && m_transport) {
+                // file trailer; offline dumps omit it because their chunks are loaded separately
+                m_copy_buffer.append("\xff\xff", 2);
+            }
+            put_copy_buffer();
+            std::string().swap(m_copy_buffer);
+            const bool usage_changed = m_budget_registered && m_budget_usage != 0;
+            m_budget_usage = 0;
+            if (!m_transport) {
+                // demo mode or offline dump
+                if (m_sink) {
+                    m_sink->end();
+                }
+                m_copy_mode = false;
+            } else {
+                StatsTimer timer{m_config.collect_stats};
+                if (m_flush_size) {
+                    finish_pending_flush();
+                    if (m_transport->set_nonblocking(false) != 0) {
+                        throw std::runtime_error(m_transport->error_message());
+                    }
+                }
+                if (m_transport->put_copy_end(nullptr) != 1) {
+                    throw std::runtime_error(m_transport->error_message());
+                }
+                PGresult *result = m_transport->get_result();
+                if (PQresultStatus(result) != PGRES_COMMAND_OK) {
+                    const std::string message = m_transport->error_message();
+                    PQclear(result);
+                    throw std::runtime_error((boost::format("COPY END command failed: %1%\n") % message).str());
+                }
+                m_copy_mode = false;
                 PQclear(result);
+                mark_written();
+                if (timer.enabled()) {
+                    ++m_stats.copy_commands;
+                    m_stats.end_copy_latency.record(timer.elapsed());
+                }
+            }
+            if (lock.owns_lock()) {
+                lock.unlock();
+            }
+            if (usage_changed) {
+                report_budget_usage(0);
             }
-            m_copy_mode = false;
-            PQclear(result);
         }
 
         /**
@@ -360,6 +1058,9 @@ namespace postgres_drivers {
         void commit() {
             send_query("COMMIT");
             m_begin = false;
+            if (m_config.collect_stats) {
+                ++m_stats.commits;
+            }
         }
 
         /**
@@ -370,19 +1071,75 @@ namespace postgres_drivers {
          * \param query the query
          */
         void send_query(const char* query) {
-            if (!m_database_connection) {
+            if (!m_transport) {
                 return;
             }
             if (m_copy_mode) {
-                throw std::runtime_error((boost::format("%1% failed: You are in COPY mode.\n%2%\n") % query % PQerrorMessage(m_database_connection)).str());
+                throw std::runtime_error((boost::format("%1% failed: You are in COPY mode.\n%2%\n") % query % m_transport->error_message()).str());
             }
-            PGresult *result = PQexec(m_database_connection, query);
+            StatsTimer timer{m_config.collect_stats};
+            PGresult *result = m_transport->exec(query);
+            if (timer.enabled()) {
+                record_statement("query", timer.elapsed(), PQresultStatus(result) != PGRES_COMMAND_OK);
+            }
+            mark_written();
             check_and_free_result(result, PGRES_COMMAND_OK, query);
         }
 
+        /**
+         * \brief Send an SQL query without waiting for its completion.
+         *
+         * Use this to run long running commands (e.g. `CREATE INDEX`) on multiple tables in parallel.
+         * Call wait_for_async_query() before the next query is sent to this table.
+         *
+         * \param query the query
+         *
+         * \throws std::runtime_error
+         */
+        void send_query_async(const char* query) {
+            if (!m_transport) {
+                return;
+            }
+            if (m_copy_mode) {
+                throw std::runtime_error((boost::format("%1% failed: You are in COPY mode.\n") % query).str());
+            }
+            if (m_transport->send_query(query) != 1) {
+                throw std::runtime_error((boost::format("%1% failed: %2%\n") % query % m_transport->error_message()).str());
+            }
+            mark_written();
+        }
+
+        /**
+         * \brief Wait for the completion of a query sent by send_query_async().
+         *
+         * \throws std::runtime_error if the query failed
+         */
+        void wait_for_async_query() {
+            if (!m_transport) {
+                return;
+            }
+            std::string message;
+            PGresult* result;
+            while ((result = m_transport->get_result()) != nullptr) {
+                if (PQresultStatus(result) != PGRES_COMMAND_OK && PQresultStatus(result) != PGRES_TUPLES_OK
+                        && message.empty()) {
+                    message = m_transport->error_message();
+                }
+                PQclear(result);
+            }
+            if (!message.empty()) {
+                throw std::runtime_error((boost::format("Query on table %1% failed: %2%\n") % m_name % message).str());
+            }
+        }
+
         /**
          * \brief Execute an SQL query returning data and return the result.
          *
+         * SELECT queries are sent to a read-only replica if replicas are configured, no
+         * `BEGIN` `COMMIT` block is open and this table has not written recently (see
+         * Config::replica_pin_after_write). If the connection to the replica is lost, the query
+         * is repeated on the primary.
+         *
          * This method cleans up memory if an error occured. If things run fine, memory cleanup
          * has to be done by the caller of this method.
          *
@@ -391,23 +1148,348 @@ namespace postgres_drivers {
          * \returns query result
          */
         PGresult* send_select_query(const char* query) {
-            assert (m_database_connection);
+            assert(m_transport);
             if (m_copy_mode) {
-                throw std::runtime_error((boost::format("%1% failed: You are in COPY mode.\n%2%\n") % query % PQerrorMessage(m_database_connection)).str());
+                throw std::runtime_error((boost::format("%1% failed: You are in COPY mode.\n%2%\n") % query % m_transport->error_message()).str());
+            }
+            const int replica = is_read_only_query(query) ? acquire_replica() : -1;
+            StatsTimer timer{timing_enabled()};
+            PGconn* connection = nullptr;
+            PGresult* result = nullptr;
+            if (replica >= 0) {
+                connection = m_replicas->connection(replica);
+                result = PQexec(connection, query);
+                if (!m_replicas->release(replica)) {
+                    PQclear(result);
+                    connection = nullptr;
+                }
+            }
+            if (!connection) {
+                connection = m_transport->connection();
+                result = m_transport->exec(query);
+                if (!is_read_only_query(query)) {
+                    mark_written();
+                }
+            }
+            const bool failed = PQresultStatus(result) != PGRES_COMMAND_OK && PQresultStatus(result) != PGRES_TUPLES_OK;
+            if (timing_enabled()) {
+                const uint64_t elapsed = timer.elapsed();
+                record_statement("select_query", elapsed, failed);
+                if (m_slow_log.enabled() && !failed && connection) {
+                    m_slow_log.log_query(connection, m_begin, m_name, query, elapsed);
+                }
             }
-            PGresult* result = PQexec(m_database_connection, query);
             std::string message;
             if (!result) {
                 throw std::runtime_error((boost::format("%1% failed\n") % query).str());
             }
-            if (PQresultStatus(result) != PGRES_COMMAND_OK && PQresultStatus(result) != PGRES_TUPLES_OK) {
-                message = PQerrorMessage(m_database_connection);
+            if (failed) {
+                message = connection != m_transport->connection() ? PQerrorMessage(connection)
+                        : m_transport->error_message();
                 PQclear(result);
                 throw std::runtime_error((boost::format("%1% failed: %2%\n") % query % message).str());
             }
             return result;
         }
 
+        /**
+         * \brief Execute a prepared statement and return the result.
+         *
+         * SELECT statements are executed on a read-only replica under the same conditions as in
+         * send_select_query().
+         *
+         * This method cleans up memory if an error occured. If things run fine, memory cleanup
+         * has to be done by the caller of this method.
+         *
+         * \param name name of the prepared statement
+         * \param params_count number of parameters
+         * \param param_values parameters in text format
+         * \param result_format 0 to get the result in text format, 1 for binary format
+         *
+         * \returns query result
+         *
+         * \throws std::runtime_error
+         */
+        PGresult* send_prepared_query(const char* name, const int params_count, const char* const* param_values,
+                const int result_format = 0) {
+            assert(m_transport);
+            if (m_copy_mode) {
+                throw std::runtime_error((boost::format("Execution of prepared statement %1% failed: You are in COPY mode.\n") % name).str());
+            }
+            const int replica = (m_replicas && m_read_only_statements.count(name)) ? acquire_replica() : -1;
+            StatsTimer timer{timing_enabled()};
+            PGconn* connection = nullptr;
+            PGresult* result = nullptr;
+            if (replica >= 0) {
+                connection = m_replicas->connection(replica);
+                result = PQexecPrepared(connection, name, params_count, param_values, nullptr, nullptr, result_format);
+                if (!m_replicas->release(replica)) {
+                    PQclear(result);
+                    connection = nullptr;
+                }
+            }
+            if (!connection) {
+                connection = m_transport->connection();
+                result = m_transport->exec_prepared(name, params_count, param_values, result_format);
+                if (!m_read_only_statements.count(name)) {
+                    mark_written();
+                }
+            }
+            const bool failed = PQresultStatus(result) != PGRES_COMMAND_OK && PQresultStatus(result) != PGRES_TUPLES_OK;
+            if (timing_enabled()) {
+                const uint64_t elapsed = timer.elapsed();
+                record_statement(name, elapsed, failed);
+                if (m_slow_log.enabled() && !failed && connection) {
+                    m_slow_log.log_prepared(connection, m_begin, m_name, name,
+                            m_prepared_statements[name], params_count, param_values, elapsed);
+                }
+            }
+            if (!result) {
+                throw std::runtime_error((boost::format("Execution of prepared statement %1% failed\n") % name).str());
+            }
+            if (failed) {
+                std::string message = connection != m_transport->connection() ? PQerrorMessage(connection)
+                        : m_transport->error_message();
+                PQclear(result);
+                throw std::runtime_error((boost::format("Execution of prepared statement %1% failed: %2%\n") % name % message).str());
+            }
+            return result;
+        }
+
+        /**
+         * \brief Create a prepared statement fetching the features of many tiles at once.
+         *
+         * See build_tile_query() for the query. If the table has a spatial index on the geometry
+         * column, the query uses it for every tile.
+         *
+         * \param name name of the prepared statement
+         * \param projection names of the columns to fetch
+         * \param geometry_column name of the geometry column to filter by, the first geometry
+         * column of the table is used if it is empty
+         *
+         * \throws std::runtime_error if a column does not exist
+         */
+        void create_tile_query(const char* name, const std::vector<std::string>& projection,
+                const std::string& geometry_column = "") {
+            ColumnsVector projected;
+            for (const std::string& column_name : projection) {
+                auto it = std::find_if(m_columns.begin(), m_columns.end(), [&column_name](const Column& column) {
+                    return column.name() == column_name;
+                });
+                if (it == m_columns.end()) {
+                    throw std::runtime_error((boost::format("Table %1% has no column %2%.\n") % m_name % column_name).str());
+                }
+                projected.push_back(*it);
+            }
+            auto geometry = std::find_if(m_columns.begin(), m_columns.end(), [&geometry_column](const Column& column) {
+                return geometry_column.empty() ? column.type() >= ColumnType::GEOMETRY : column.name() == geometry_column;
+            });
+            if (geometry == m_columns.end() || geometry->type() < ColumnType::GEOMETRY) {
+                throw std::runtime_error((boost::format("Table %1% has no geometry column %2%.\n") % m_name % geometry_column).str());
+            }
+            create_prepared_statement(name, build_tile_query(m_name, projected, *geometry), 5);
+        }
+
+        /**
+         * \brief Fetch the features of many tiles using a statement created by create_tile_query().
+         *
+         * The tiles are fetched in batches of Config::tile_query_batch_size tiles, each batch needs
+         * one round trip. Values are returned in binary format.
+         *
+         * \param name name of the prepared statement
+         * \param tiles bounding boxes of the tiles
+         *
+         * \returns features grouped by tile, in the order of `tiles`
+         *
+         * \throws std::runtime_error
+         */
+        TileQueryResult send_tile_query(const char* name, const std::vector<TileBounds>& tiles) {
+            TileQueryResult result{tiles.size()};
+            const size_t batch_size = std::max(m_config.tile_query_batch_size, static_cast<size_t>(1));
+            std::string params[5];
+            for (size_t begin = 0; begin < tiles.size(); begin += batch_size) {
+                const size_t end = std::min(begin + batch_size, tiles.size());
+                build_tile_query_params(tiles, begin, end, params);
+                const char* const param_values[] = {params[0].c_str(), params[1].c_str(), params[2].c_str(),
+                        params[3].c_str(), params[4].c_str()};
+                result.add_batch(send_prepared_query(name, 5, param_values, 1), begin, end);
+            }
+            return result;
+        }
+
+        /**
+         * \brief Get the location of a node from a POINT or UNTAGGED_POINT table.
+         *
+         * Results are cached if Config::lookup_cache_memory is larger than 0. Nodes which were not found
+         * are not cached.
+         *
+         * \param id OSM ID of the node
+         *
+         * \returns location or an undefined location if the node is not in this table
+         *
+         * \throws std::runtime_error
+         */
+        osmium::Location get_location(const osmium::object_id_type id) {
+            if (m_location_cache) {
+                const osmium::Location* cached = m_location_cache->get(id);
+                if (cached) {
+                    return *cached;
+                }
+            }
+            std::string id_str = std::to_string(id);
+            const char* param_values[] = {id_str.c_str()};
+            osmium::Location location;
+            PGresult* result;
+            if (m_columns.get_type() == TableType::POINT) {
+                result = send_prepared_query("get_location_from_point_table", 1, param_values);
+                if (PQntuples(result) > 0) {
+                    location = osmium::Location{atof(PQgetvalue(result, 0, 0)), atof(PQgetvalue(result, 0, 1))};
+                }
+            } else {
+                result = send_prepared_query("get_location_from_untagged_nodes_table", 1, param_values);
+                if (PQntuples(result) > 0) {
+                    location = osmium::Location{static_cast<int32_t>(atoi(PQgetvalue(result, 0, 0))),
+                            static_cast<int32_t>(atoi(PQgetvalue(result, 0, 1)))};
+                }
+            }
+            PQclear(result);
+            if (m_location_cache && location.is_defined()) {
+                m_location_cache->put(id, location);
+            }
+            return location;
+        }
+
+        /**
+         * \brief Get the IDs of all ways using a node from a NODE_WAYS table.
+         *
+         * Results are cached if Config::lookup_cache_memory is larger than 0.
+         *
+         * \param node_id OSM ID of the node
+         *
+         * \throws std::runtime_error
+         */
+        std::vector<osmium::object_id_type> get_way_ids(const osmium::object_id_type node_id) {
+            if (m_way_ids_cache) {
+                const std::vector<osmium::object_id_type>* cached = m_way_ids_cache->get(node_id);
+                if (cached) {
+                    return *cached;
+                }
+            }
+            std::string id_str = std::to_string(node_id);
+            const char* param_values[] = {id_str.c_str()};
+            PGresult* result = send_prepared_query("get_way_ids", 1, param_values);
+            std::vector<osmium::object_id_type> way_ids;
+            const int count = PQntuples(result);
+            way_ids.reserve(count);
+            for (int i = 0; i < count; ++i) {
+                way_ids.push_back(strtoll(PQgetvalue(result, i, 0), nullptr, 10));
+            }
+            PQclear(result);
+            if (m_way_ids_cache) {
+                m_way_ids_cache->put(node_id, way_ids);
+            }
+            return way_ids;
+        }
+
+        /**
+         * \brief Delete an object using the prepared statement `delete_statement`.
+         *
+         * Its cached location is invalidated.
+         *
+         * \throws std::runtime_error
+         */
+        void delete_object(const osmium::object_id_type id) {
+            invalidate_location(id);
+            std::string id_str = std::to_string(id);
+            const char* param_values[] = {id_str.c_str()};
+            PQclear(send_prepared_query("delete_statement", 1, param_values));
+        }
+
+        /**
+         * \brief Delete the node list of a way from a NODE_WAYS table.
+         *
+         * The cached way IDs of its nodes are invalidated.
+         *
+         * \throws std::runtime_error
+         */
+        void delete_way_node_list(const osmium::object_id_type way_id) {
+            std::string id_str = std::to_string(way_id);
+            const char* param_values[] = {id_str.c_str()};
+            PGresult* result = send_prepared_query("delete_way_node_list", 1, param_values);
+            if (m_way_ids_cache) {
+                const int count = PQntuples(result);
+                for (int i = 0; i < count; ++i) {
+                    m_way_ids_cache->invalidate(strtoll(PQgetvalue(result, i, 0), nullptr, 10));
+                }
+            }
+            PQclear(result);
+        }
+
+        /**
+         * \brief Remove a node from the location cache.
+         *
+         * Call this method if you modify the location of a node without using the methods of this class.
+         */
+        void invalidate_location(const osmium::object_id_type id) {
+            if (m_location_cache) {
+                m_location_cache->invalidate(id);
+            }
+        }
+
+        /**
+         * \brief Remove a node from the way ID cache.
+         *
+         * Call this method if you modify the ways using a node without using the methods of this class.
+         */
+        void invalidate_way_ids(const osmium::object_id_type node_id) {
+            if (m_way_ids_cache) {
+                m_way_ids_cache->invalidate(node_id);
+            }
+        }
+
+        /**
+         * \brief Get the statistics of the location cache.
+         *
+         * \returns statistics or nullptr if this table has no location cache
+         */
+        const LookupCacheStats* location_cache_stats() const {
+            return m_location_cache ? &m_location_cache->stats() : nullptr;
+        }
+
+        /**
+         * \brief Get the statistics of the way ID cache.
+         *
+         * \returns statistics or nullptr if this table has no way ID cache
+         */
+        const LookupCacheStats* way_ids_cache_stats() const {
+            return m_way_ids_cache ? &m_way_ids_cache->stats() : nullptr;
+        }
+
+        /**
+         * \brief Get the performance counters of this table.
+         *
+         * The counters are only updated if Config::collect_stats is true. Copy the returned object
+         * to get a snapshot.
+         */
+        const TableStats& stats() const {
+            return m_stats;
+        }
+
+        /**
+         * \brief Get the size at which the COPY buffer is passed to libpq. It changes over time if
+         * Config::adaptive_copy_buffer is enabled.
+         */
+        size_t copy_flush_size() const noexcept {
+            return copy_buffer_limit();
+        }
+
+        /**
+         * \brief Reset all performance counters of this table.
+         */
+        void reset_stats() {
+            m_stats = TableStats{};
+        }
+
         /*
          * \brief Send `COMMIT` to table and checks if this is currently allowed (i.e. currently not in `COPY` mode)
          *
@@ -0,0 +1,307 @@
+/*
+ * table_stats.hpp
+ *
+ *  Created on:  2026-10-18
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef INCLUDE_POSTGRES_DRIVERS_TABLE_STATS_HPP_
+#define INCLUDE_POSTGRES_DRIVERS_TABLE_STATS_HPP_
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+namespace postgres_drivers {
+
+    /**
+     * \brief Histogram of latencies with logarithmic buckets and linear sub-buckets (similar to HdrHistogram).
+     *
+     * Values are recorded in nanoseconds. The relative error of a recorded value is less than 1/16.
+     */
+    class LatencyHistogram {
+
+        static constexpr int SUB_BUCKET_BITS = 5;
+
+        static constexpr int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+
+        static constexpr int SUB_BUCKET_HALF = SUB_BUCKET_COUNT / 2;
+
+        /// The first bucket has #SUB_BUCKET_COUNT counters, all further buckets have #SUB_BUCKET_HALF counters.
+        static constexpr int COUNTER_COUNT = SUB_BUCKET_COUNT + (64 - SUB_BUCKET_BITS) * SUB_BUCKET_HALF;
+
+        std::array<uint64_t, COUNTER_COUNT> m_counts;
+
+        uint64_t m_count = 0;
+
+        uint64_t m_sum = 0;
+
+        uint64_t m_min = std::numeric_limits<uint64_t>::max();
+
+        uint64_t m_max = 0;
+
+        static int magnitude(uint64_t value) noexcept {
+            int bits = 0;
+            while (value >= SUB_BUCKET_COUNT) {
+                value >>= 1;
+                ++bits;
+            }
+            return bits;
+        }
+
+        static size_t index_of(const uint64_t value) noexcept {
+            const int bucket = magnitude(value);
+            if (bucket == 0) {
+                return static_cast<size_t>(value);
+            }
+            // value >> bucket is in [SUB_BUCKET_HALF, SUB_BUCKET_COUNT)
+            return SUB_BUCKET_COUNT + (bucket - 1) * SUB_BUCKET_HALF + static_cast<size_t>(value >> bucket) - SUB_BUCKET_HALF;
+        }
+
+        /**
+         * Get the highest value which falls into a counter.
+         */
+        static uint64_t value_of(const size_t index) noexcept {
+            if (index < SUB_BUCKET_COUNT) {
+                return index;
+            }
+            const int bucket = static_cast<int>((index - SUB_BUCKET_COUNT) / SUB_BUCKET_HALF) + 1;
+            const uint64_t sub_bucket = (index - SUB_BUCKET_COUNT) % SUB_BUCKET_HALF + SUB_BUCKET_HALF;
+            return ((sub_bucket + 1) << bucket) - 1;
+        }
+
+    public:
+        LatencyHistogram() {
+            m_counts.fill(0);
+        }
+
+        void record(const uint64_t nanoseconds) noexcept {
+            ++m_counts[index_of(nanoseconds)];
+            ++m_count;
+            m_sum += nanoseconds;
+            if (nanoseconds < m_min) {
+                m_min = nanoseconds;
+            }
+            if (nanoseconds > m_max) {
+                m_max = nanoseconds;
+            }
+        }
+
+        uint64_t count() const noexcept {
+            return m_count;
+        }
+
+        uint64_t sum() const noexcept {
+            return m_sum;
+        }
+
+        uint64_t min() const noexcept {
+            return m_count ? m_min : 0;
+        }
+
+        uint64_t max() const noexcept {
+            return m_max;
+        }
+
+        double mean() const noexcept {
+            return m_count ? static_cast<double>(m_sum) / m_count : 0.0;
+        }
+
+        /**
+         * \brief Get the value below or at which the given percentage of all recorded values are.
+         *
+         * \param percentile percentile between 0 and 100
+         */
+        uint64_t percentile(const double percentile) const noexcept {
+            if (m_count == 0) {
+                return 0;
+            }
+            uint64_t threshold = static_cast<uint64_t>(percentile / 100.0 * m_count + 0.5);
+            if (threshold == 0) {
+                threshold = 1;
+            }
+            uint64_t seen = 0;
+            for (size_t i = 0; i < m_counts.size(); ++i) {
+                seen += m_counts[i];
+                if (seen >= threshold) {
+                    return std::min(value_of(i), m_max);
+                }
+            }
+            return m_max;
+        }
+    };
+
+    /**
+     * \brief Number of calls and latencies of a prepared statement or a query.
+     */
+    struct StatementStats {
+        uint64_t calls = 0;
+        uint64_t errors = 0;
+        LatencyHistogram latency;
+    };
+
+    /**
+     * \brief Performance counters of a Table.
+     *
+     * The counters are only updated if Config::collect_stats is true.
+     */
+    struct TableStats {
+        /// number of rows sent using COPY
+        uint64_t rows = 0;
+        /// number of bytes sent using COPY
+        uint64_t bytes = 0;
+        /// number of times the COPY buffer was passed to libpq or to the CopySink
+        uint64_t flushes = 0;
+        /// number of completed COPY commands
+        uint64_t copy_commands = 0;
+        /// number of COMMITs
+        uint64_t commits = 0;
+        /// current size at which the COPY buffer is passed to libpq
+        uint64_t copy_buffer_size = 0;
+        /// number of changes of the COPY buffer size (Config::adaptive_copy_buffer)
+        uint64_t copy_buffer_adjustments = 0;
+        /// number of COPY buffers which could not be sent completely without blocking
+        uint64_t would_block = 0;
+        /// number of times the producer waited for the socket to become writable
+        uint64_t stalls = 0;
+        /// time the producer waited for the socket to become writable in nanoseconds
+        uint64_t stall_time = 0;
+        /// time spent waiting for the end of COPY commands
+        LatencyHistogram end_copy_latency;
+        /// statistics per prepared statement, ad-hoc queries are listed as `query` and `select_query`
+        std::map<std::string, StatementStats> statements;
+
+        /**
+         * \brief Write the statistics as human readable text.
+         *
+         * \param out output stream
+         * \param table_name name of the table the statistics belong to
+         */
+        void dump_text(std::ostream& out, const std::string& table_name) const {
+            out << "table " << table_name << ": rows=" << rows << " bytes=" << bytes << " flushes=" << flushes
+                    << " copy_commands=" << copy_commands << " commits=" << commits << "\n";
+            out << "  copy_buffer: size=" << copy_buffer_size << " adjustments=" << copy_buffer_adjustments
+                    << " would_block=" << would_block << " stalls=" << stalls << " stall_time=" << stall_time / 1000
+                    << "us\n";
+            out << "  end_copy: ";
+            dump_histogram_text(out, end_copy_latency);
+            for (const auto& statement : statements) {
+                out << "  " << statement.first << ": calls=" << statement.second.calls << " errors="
+                        << statement.second.errors << " ";
+                dump_histogram_text(out, statement.second.latency);
+            }
+        }
+
+        /**
+         * \brief Write the statistics as a JSON object.
+         *
+         * Latencies are given in microseconds.
+         *
+         * \param out output stream
+         * \param table_name name of the table the statistics belong to
+         */
+        void dump_json(std::ostream& out, const std::string& table_name) const {
+            out << "{\"table\":";
+            write_json_string(out, table_name);
+            out << ",\"rows\":" << rows << ",\"bytes\":" << bytes << ",\"flushes\":" << flushes << ",\"copy_commands\":"
+                    << copy_commands << ",\"commits\":" << commits << ",\"copy_buffer\":{\"size\":" << copy_buffer_size
+                    << ",\"adjustments\":" << copy_buffer_adjustments << ",\"would_block\":" << would_block
+                    << ",\"stalls\":" << stalls << ",\"stall_time_us\":" << stall_time / 1000.0 << "},\"end_copy\":";
+            dump_histogram_json(out, end_copy_latency);
+            out << ",\"statements\":{";
+            for (auto it = statements.begin(); it != statements.end(); ++it) {
+                if (it != statements.begin()) {
+                    out << ',';
+                }
+                write_json_string(out, it->first);
+                out << ":{\"calls\":" << it->second.calls << ",\"errors\":" << it->second.errors << ",\"latency\":";
+                dump_histogram_json(out, it->second.latency);
+                out << '}';
+            }
+            out << "}}";
+        }
+
+        std::string to_text(const std::string& table_name) const {
+            std::ostringstream out;
+            dump_text(out, table_name);
+            return out.str();
+        }
+
+        std::string to_json(const std::string& table_name) const {
+            std::ostringstream out;
+            dump_json(out, table_name);
+            return out.str();
+        }
+
+        static void write_json_string(std::ostream& out, const std::string& str) {
+            out << '"';
+            for (const char c : str) {
+                if (c == '"' || c == '\\') {
+                    out << '\\' << c;
+                } else if (static_cast<unsigned char>(c) < 0x20) {
+                    const char* hex = "0123456789abcdef";
+                    out << "\\u00" << hex[(c >> 4) & 0xf] << hex[c & 0xf];
+                } else {
+                    out << c;
+                }
+            }
+            out << '"';
+        }
+
+    private:
+        static void dump_histogram_text(std::ostream& out, const LatencyHistogram& histogram) {
+            out << "count=" << histogram.count() << " mean=" << histogram.mean() / 1000 << "us p50="
+                    << histogram.percentile(50) / 1000.0 << "us p99=" << histogram.percentile(99) / 1000.0
+                    << "us max=" << histogram.max() / 1000.0 << "us\n";
+        }
+
+        static void dump_histogram_json(std::ostream& out, const LatencyHistogram& histogram) {
+            out << "{\"count\":" << histogram.count() << ",\"sum_us\":" << histogram.sum() / 1000.0 << ",\"min_us\":"
+                    << histogram.min() / 1000.0 << ",\"mean_us\":" << histogram.mean() / 1000 << ",\"p50_us\":"
+                    << histogram.percentile(50) / 1000.0 << ",\"p90_us\":" << histogram.percentile(90) / 1000.0
+                    << ",\"p99_us\":" << histogram.percentile(99) / 1000.0 << ",\"p999_us\":"
+                    << histogram.percentile(99.9) / 1000.0 << ",\"max_us\":" << histogram.max() / 1000.0 << '}';
+        }
+    };
+
+    /**
+     * \brief Measure the duration of an operation if statistics are enabled.
+     *
+     * The clock is only read if the timer is enabled.
+     */
+    class StatsTimer {
+
+        std::chrono::steady_clock::time_point m_start;
+
+        bool m_enabled;
+
+    public:
+        explicit StatsTimer(const bool enabled) :
+            m_start(),
+            m_enabled(enabled) {
+            if (m_enabled) {
+                m_start = std::chrono::steady_clock::now();
+            }
+        }
+
+        bool enabled() const noexcept {
+            return m_enabled;
+        }
+
+        /**
+         * \brief Get the elapsed time in nanoseconds.
+         */
+        uint64_t elapsed() const {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - m_start).count());
+        }
+    };
+}
+
+#endif /* INCLUDE_POSTGRES_DRIVERS_TABLE_STATS_HPP_ */
@@ -0,0 +1,294 @@
+/*
+ * tile_query.hpp
+ *
+ *  Created on:  2026-10-18
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef INCLUDE_POSTGRES_DRIVERS_TILE_QUERY_HPP_
+#define INCLUDE_POSTGRES_DRIVERS_TILE_QUERY_HPP_
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/format.hpp>
+#include <libpq-fe.h>
+
+#include "columns.hpp"
+
+namespace postgres_drivers {
+
+    /**
+     * \brief Bounding box of a tile in the coordinate system of the geometry column.
+     */
+    struct TileBounds {
+        double min_x;
+        double min_y;
+        double max_x;
+        double max_y;
+
+        /**
+         * \brief Get the bounds of a tile of the Web Mercator tile scheme in WGS84 coordinates (EPSG:4326).
+         */
+        static TileBounds from_tile(const uint32_t zoom, const uint32_t x, const uint32_t y) {
+            const double tiles = std::ldexp(1.0, static_cast<int>(zoom));
+            const double pi = std::acos(-1.0);
+            auto lat = [tiles, pi](const double tile_y) {
+                return std::atan(std::sinh(pi * (1 - 2 * tile_y / tiles))) * 180 / pi;
+            };
+            return TileBounds{x / tiles * 360 - 180, lat(y + 1), (x + 1) / tiles * 360 - 180, lat(y)};
+        }
+    };
+
+    namespace detail {
+
+        inline void append_double(const double value, std::string& dest) {
+            char buffer[32];
+            std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+            dest.append(buffer);
+        }
+
+        template <size_t TSize>
+        struct unsigned_of_size;
+
+        template <>
+        struct unsigned_of_size<2> {
+            using type = uint16_t;
+        };
+
+        template <>
+        struct unsigned_of_size<4> {
+            using type = uint32_t;
+        };
+
+        template <>
+        struct unsigned_of_size<8> {
+            using type = uint64_t;
+        };
+
+        /**
+         * Decode a big endian integer or floating point number. The bytes are assembled in an unsigned
+         * integer of the same size whose representation is then copied, independent of the byte order
+         * of the host.
+         */
+        template <typename TValue>
+        TValue read_big_endian(const char* data) {
+            using unsigned_type = typename unsigned_of_size<sizeof(TValue)>::type;
+            unsigned_type value = 0;
+            for (size_t i = 0; i < sizeof(TValue); ++i) {
+                value = static_cast<unsigned_type>((value << 8) | static_cast<unsigned char>(data[i]));
+            }
+            TValue result;
+            std::memcpy(&result, &value, sizeof(TValue));
+            return result;
+        }
+    }
+
+    /**
+     * \brief Build the query of a prepared statement returning the features of many tiles at once.
+     *
+     * The statement has five array parameters: tile numbers, minimum x, minimum y, maximum x and
+     * maximum y. They are expanded using `unnest` and joined with the table by the bounding box
+     * operator `&&` which can use the index of the geometry column. The first column of the result is
+     * the tile number, the other columns are the projection.
+     *
+     * \param table_name name of the table
+     * \param projection columns to return
+     * \param geometry geometry column to filter by
+     */
+    inline std::string build_tile_query(const std::string& table_name, const ColumnsVector& projection,
+            const Column& geometry) {
+        std::string query = "SELECT b.tile";
+        for (const Column& column : projection) {
+            query.append(", t.\"" + column.name() + "\"");
+        }
+        query.append(" FROM unnest($1::int4[], $2::float8[], $3::float8[], $4::float8[], $5::float8[])"
+                " AS b(tile, min_x, min_y, max_x, max_y) JOIN ");
+        query.append(table_name);
+        query.append(" AS t ON t.\"" + geometry.name() + "\" && ST_MakeEnvelope(b.min_x, b.min_y, b.max_x, b.max_y");
+        if (geometry.epsg() != 0) {
+            query.append(", " + std::to_string(geometry.epsg()));
+        }
+        query.push_back(')');
+        return query;
+    }
+
+    /**
+     * \brief Build the parameters of a tile query for a batch of tiles.
+     *
+     * \param tiles bounding boxes of all tiles
+     * \param begin index of the first tile of the batch
+     * \param end index after the last tile of the batch
+     * \param params array of five strings to write the parameters (text format) to
+     */
+    inline void build_tile_query_params(const std::vector<TileBounds>& tiles, const size_t begin, const size_t end,
+            std::string* params) {
+        for (size_t p = 0; p < 5; ++p) {
+            params[p] = "{";
+        }
+        for (size_t i = begin; i < end; ++i) {
+            if (i != begin) {
+                for (size_t p = 0; p < 5; ++p) {
+                    params[p].push_back(',');
+                }
+            }
+            params[0].append(std::to_string(i - begin));
+            detail::append_double(tiles[i].min_x, params[1]);
+            detail::append_double(tiles[i].min_y, params[2]);
+            detail::append_double(tiles[i].max_x, params[3]);
+            detail::append_double(tiles[i].max_y, params[4]);
+        }
+        for (size_t p = 0; p < 5; ++p) {
+            params[p].push_back('}');
+        }
+    }
+
+    /**
+     * \brief Result of a tile query, grouped by tile.
+     *
+     * All values are in the binary format of PostgreSQL. Integers and floating point numbers are
+     * big endian, text is not null-terminated and geometries are EWKB. Column 0 is the first column
+     * of the projection.
+     */
+    class TileQueryResult {
+
+        using result_ptr = std::unique_ptr<PGresult, decltype(&PQclear)>;
+
+        std::vector<result_ptr> m_results;
+
+        /// result index and row number of all features, ordered by tile
+        std::vector<std::pair<size_t, int>> m_rows;
+
+        /// index of the first feature of each tile in m_rows, the last entry is the number of features
+        std::vector<size_t> m_offsets;
+
+        const std::pair<size_t, int>& row(const size_t tile, const size_t feature) const {
+            return m_rows[m_offsets[tile] + feature];
+        }
+
+    public:
+        explicit TileQueryResult(const size_t tile_count) :
+            m_results(),
+            m_rows(),
+            m_offsets(tile_count + 1, 0) {
+        }
+
+        /**
+         * \brief Add the result of a batch of tiles and group its rows by tile.
+         *
+         * Batches have to be added in the order of their tiles.
+         *
+         * \param result query result, the object takes ownership
+         * \param first_tile index of the first tile of the batch
+         * \param end_tile index after the last tile of the batch
+         */
+        void add_batch(PGresult* result, const size_t first_tile, const size_t end_tile) {
+            m_results.emplace_back(result, &PQclear);
+            const size_t result_index = m_results.size() - 1;
+            const int row_count = PQntuples(result);
+            std::vector<size_t> tiles(row_count);
+            std::vector<size_t> counts(end_tile - first_tile, 0);
+            for (int r = 0; r < row_count; ++r) {
+                tiles[r] = static_cast<size_t>(detail::read_big_endian<int32_t>(PQgetvalue(result, r, 0)));
+                if (tiles[r] >= counts.size()) {
+                    throw std::runtime_error("Tile query returned an invalid tile number.\n");
+                }
+                ++counts[tiles[r]];
+            }
+            size_t offset = m_rows.size();
+            for (size_t t = 0; t < counts.size(); ++t) {
+                m_offsets[first_tile + t] = offset;
+                offset += counts[t];
+            }
+            m_offsets[end_tile] = offset;
+            std::vector<size_t> next(m_offsets.begin() + first_tile, m_offsets.begin() + end_tile);
+            m_rows.resize(offset);
+            for (int r = 0; r < row_count; ++r) {
+                m_rows[next[tiles[r]]++] = std::make_pair(result_index, r);
+            }
+        }
+
+        /**
+         * \brief Get the number of tiles.
+         */
+        size_t size() const noexcept {
+            return m_offsets.size() - 1;
+        }
+
+        /**
+         * \brief Get the number of features in a tile.
+         */
+        size_t feature_count(const size_t tile) const {
+            return m_offsets.at(tile + 1) - m_offsets.at(tile);
+        }
+
+        bool is_null(const size_t tile, const size_t feature, const int column) const {
+            const auto& r = row(tile, feature);
+            return PQgetisnull(m_results[r.first].get(), r.second, column + 1);
+        }
+
+        /**
+         * \brief Get the value of a column in binary format.
+         */
+        const char* value(const size_t tile, const size_t feature, const int column) const {
+            const auto& r = row(tile, feature);
+            return PQgetvalue(m_results[r.first].get(), r.second, column + 1);
+        }
+
+        /**
+         * \brief Get the length of a value in bytes.
+         */
+        int length(const size_t tile, const size_t feature, const int column) const {
+            const auto& r = row(tile, feature);
+            return PQgetlength(m_results[r.first].get(), r.second, column + 1);
+        }
+
+        /**
+         * \brief Get the value of a SMALLINT, INT or BIGINT column.
+         */
+        int64_t get_integer(const size_t tile, const size_t feature, const int column) const {
+            const char* data = value(tile, feature, column);
+            switch (length(tile, feature, column)) {
+            case 2:
+                return detail::read_big_endian<int16_t>(data);
+            case 4:
+                return detail::read_big_endian<int32_t>(data);
+            case 8:
+                return detail::read_big_endian<int64_t>(data);
+            default:
+                throw std::runtime_error((boost::format("Column %1% of the tile query is not an integer.\n") % column).str());
+            }
+        }
+
+        /**
+         * \brief Get the value of a REAL or double precision column.
+         */
+        double get_real(const size_t tile, const size_t feature, const int column) const {
+            const char* data = value(tile, feature, column);
+            switch (length(tile, feature, column)) {
+            case 4:
+                return detail::read_big_endian<float>(data);
+            case 8:
+                return detail::read_big_endian<double>(data);
+            default:
+                throw std::runtime_error((boost::format("Column %1% of the tile query is not a floating point number.\n") % column).str());
+            }
+        }
+
+        /**
+         * \brief Get the value of a text column or the EWKB of a geometry column.
+         */
+        std::string get_string(const size_t tile, const size_t feature, const int column) const {
+            return std::string(value(tile, feature, column), length(tile, feature, column));
+        }
+    };
+}
+
+#endif /* INCLUDE_POSTGRES_DRIVERS_TILE_QUERY_HPP_ */
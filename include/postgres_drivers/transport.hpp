@@ -0,0 +1,189 @@
+/*
+ * transport.hpp
+ *
+ *  Created on:  2026-10-18
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef INCLUDE_POSTGRES_DRIVERS_TRANSPORT_HPP_
+#define INCLUDE_POSTGRES_DRIVERS_TRANSPORT_HPP_
+
+#include <libpq-fe.h>
+
+namespace postgres_drivers {
+
+    /**
+     * \brief Connection of a Table to the database.
+     *
+     * The methods correspond to the libpq functions of the same name. Returned results are owned
+     * by the caller and have to be freed using `PQclear()`.
+     *
+     * Implementations: LibpqTransport (a real connection), RecordingTransport and ReplayTransport
+     * (transport_recording.hpp).
+     */
+    class Transport {
+
+    public:
+        virtual ~Transport() = default;
+
+        /**
+         * \brief Error message of the last failed operation.
+         */
+        virtual const char* error_message() = 0;
+
+        virtual PGresult* exec(const char* command) = 0;
+
+        virtual PGresult* prepare(const char* name, const char* query, const int params_count) = 0;
+
+        /**
+         * \param result_format 0 for text, 1 for binary
+         */
+        virtual PGresult* exec_prepared(const char* name, const int params_count, const char* const* param_values,
+                const int result_format) = 0;
+
+        /**
+         * \returns 1 on success, 0 on failure
+         */
+        virtual int send_query(const char* query) = 0;
+
+        /**
+         * \returns next result of a query sent by send_query() or COPY, nullpointer if there are no
+         * more results
+         */
+        virtual PGresult* get_result() = 0;
+
+        /**
+         * \returns 1 on success, 0 if the data could not be queued (nonblocking mode), -1 on failure
+         */
+        virtual int put_copy_data(const char* data, const int size) = 0;
+
+        /**
+         * \returns 1 on success, 0 if the data could not be queued (nonblocking mode), -1 on failure
+         */
+        virtual int put_copy_end(const char* error_message) = 0;
+
+        /**
+         * \returns 0 if all data has been sent, 1 if data is pending (nonblocking mode), -1 on failure
+         */
+        virtual int flush() = 0;
+
+        /**
+         * \returns 0 on success, -1 on failure
+         */
+        virtual int set_nonblocking(const bool nonblocking) = 0;
+
+        /**
+         * \brief File descriptor of the socket, -1 if there is none.
+         */
+        virtual int socket() = 0;
+
+        /**
+         * \returns 1 on success, 0 on failure
+         */
+        virtual int consume_input() = 0;
+
+        /**
+         * \brief Underlying libpq connection, nullpointer if there is none (e.g. during replay).
+         *
+         * Operations executed directly on this connection bypass the transport.
+         */
+        virtual PGconn* connection() = 0;
+
+        /**
+         * \brief May a Table send read-only queries to replicas (see Config::replica_conninfos)?
+         *
+         * These queries bypass the transport. Transports which have to see all queries (e.g.
+         * recording or replay) must return false.
+         */
+        virtual bool supports_replicas() const {
+            return false;
+        }
+    };
+
+    /**
+     * \brief Transport using a libpq connection.
+     */
+    class LibpqTransport : public Transport {
+
+        PGconn* m_connection;
+
+    public:
+        /**
+         * \brief Connect to the database. Check the result using connected().
+         */
+        explicit LibpqTransport(const char* conninfo) :
+            m_connection(PQconnectdb(conninfo)) {
+        }
+
+        LibpqTransport(const LibpqTransport&) = delete;
+
+        LibpqTransport& operator=(const LibpqTransport&) = delete;
+
+        ~LibpqTransport() {
+            PQfinish(m_connection);
+        }
+
+        bool connected() const {
+            return PQstatus(m_connection) == CONNECTION_OK;
+        }
+
+        const char* error_message() override {
+            return PQerrorMessage(m_connection);
+        }
+
+        PGresult* exec(const char* command) override {
+            return PQexec(m_connection, command);
+        }
+
+        PGresult* prepare(const char* name, const char* query, const int params_count) override {
+            return PQprepare(m_connection, name, query, params_count, nullptr);
+        }
+
+        PGresult* exec_prepared(const char* name, const int params_count, const char* const* param_values,
+                const int result_format) override {
+            return PQexecPrepared(m_connection, name, params_count, param_values, nullptr, nullptr, result_format);
+        }
+
+        int send_query(const char* query) override {
+            return PQsendQuery(m_connection, query);
+        }
+
+        PGresult* get_result() override {
+            return PQgetResult(m_connection);
+        }
+
+        int put_copy_data(const char* data, const int size) override {
+            return PQputCopyData(m_connection, data, size);
+        }
+
+        int put_copy_end(const char* error_message) override {
+            return PQputCopyEnd(m_connection, error_message);
+        }
+
+        int flush() override {
+            return PQflush(m_connection);
+        }
+
+        int set_nonblocking(const bool nonblocking) override {
+            return PQsetnonblocking(m_connection, nonblocking ? 1 : 0);
+        }
+
+        int socket() override {
+            return PQsocket(m_connection);
+        }
+
+        int consume_input() override {
+            return PQconsumeInput(m_connection);
+        }
+
+        PGconn* connection() override {
+            return m_connection;
+        }
+
+        bool supports_replicas() const override {
+            return true;
+        }
+    };
+}
+
+#endif /* INCLUDE_POSTGRES_DRIVERS_TRANSPORT_HPP_ */
@@ -0,0 +1,562 @@
+/*
+ * transport_recording.hpp
+ *
+ *  Created on:  2026-10-18
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef INCLUDE_POSTGRES_DRIVERS_TRANSPORT_RECORDING_HPP_
+#define INCLUDE_POSTGRES_DRIVERS_TRANSPORT_RECORDING_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/format.hpp>
+#include <libpq-fe.h>
+
+#include "transport.hpp"
+
+/**
+ * \file
+ *
+ * Recording format (text, one record per line, fields separated by tabs):
+ *
+ *     cerepso-transport 1
+ *     <operation> <duration_ns> <return value> <error message> <arguments...>
+ *     result <status> <rows> <fields>          (after operations returning a result)
+ *     field <name> <type OID> <format>         (once per field)
+ *     row <value> <value> ...                  (once per row, NULL is \N)
+ *
+ * Operations: exec (command), prepare (name, query, number of parameters), exec_prepared
+ * (name, result format, parameters), send_query (query), get_result, put_copy_data (size),
+ * put_copy_end. The return value of operations returning a result is 1 if a result follows,
+ * 0 for a nullpointer. Backslash, tab, newline, carriage return and other control characters are
+ * escaped (`\\`, `\t`, `\n`, `\r`, `\xHH`).
+ */
+
+namespace postgres_drivers {
+
+    namespace detail {
+
+        constexpr const char* transport_recording_header = "cerepso-transport 1";
+
+        inline void append_escaped(const char* data, const size_t size, std::string& dest) {
+            static const char hex[] = "0123456789abcdef";
+            for (size_t i = 0; i < size; ++i) {
+                const unsigned char c = static_cast<unsigned char>(data[i]);
+                switch (c) {
+                case '\\':
+                    dest.append("\\\\");
+                    break;
+                case '\t':
+                    dest.append("\\t");
+                    break;
+                case '\n':
+                    dest.append("\\n");
+                    break;
+                case '\r':
+                    dest.append("\\r");
+                    break;
+                default:
+                    if (c < 0x20 || c == 0x7f) {
+                        dest.append("\\x");
+                        dest.push_back(hex[c >> 4]);
+                        dest.push_back(hex[c & 0xf]);
+                    } else {
+                        dest.push_back(static_cast<char>(c));
+                    }
+                }
+            }
+        }
+
+        struct RecordedField {
+            std::string value;
+            bool null = false;
+        };
+
+        /**
+         * Split a line of a recording into its unescaped fields.
+         */
+        inline void split_recorded_line(const std::string& line, std::vector<RecordedField>& fields) {
+            fields.clear();
+            fields.emplace_back();
+            for (size_t i = 0; i < line.size(); ++i) {
+                const char c = line[i];
+                if (c == '\t') {
+                    fields.emplace_back();
+                    continue;
+                }
+                if (c != '\\' || i + 1 == line.size()) {
+                    fields.back().value.push_back(c);
+                    continue;
+                }
+                const char next = line[++i];
+                if (next == 't') {
+                    fields.back().value.push_back('\t');
+                } else if (next == 'n') {
+                    fields.back().value.push_back('\n');
+                } else if (next == 'r') {
+                    fields.back().value.push_back('\r');
+                } else if (next == 'N') {
+                    fields.back().null = true;
+                } else if (next == 'x' && i + 2 < line.size()) {
+                    fields.back().value.push_back(static_cast<char>(std::strtol(line.substr(i + 1, 2).c_str(), nullptr, 16)));
+                    i += 2;
+                } else {
+                    fields.back().value.push_back(next);
+                }
+            }
+        }
+    }
+
+    /**
+     * \brief Transport which forwards all operations to another transport and records them,
+     * their results and their durations to a file.
+     *
+     * Replay the file using ReplayTransport. The content of COPY data is not recorded, only its size.
+     * Operations which do not involve the server (flush, socket, nonblocking mode) are not
+     * recorded either.
+     */
+    class RecordingTransport : public Transport {
+
+        std::unique_ptr<Transport> m_transport;
+
+        std::string m_path;
+
+        std::ofstream m_out;
+
+        std::string m_line;
+
+        void start_record(const char* operation, const uint64_t duration, const int return_value) {
+            m_line.assign(operation);
+            m_line.push_back('\t');
+            m_line.append(std::to_string(duration));
+            m_line.push_back('\t');
+            m_line.append(std::to_string(return_value));
+            m_line.push_back('\t');
+            const char* message = m_transport->error_message();
+            detail::append_escaped(message, std::strlen(message), m_line);
+        }
+
+        void add_argument(const char* value) {
+            m_line.push_back('\t');
+            if (value) {
+                detail::append_escaped(value, std::strlen(value), m_line);
+            } else {
+                m_line.append("\\N");
+            }
+        }
+
+        void add_result(const PGresult* result) {
+            m_line.push_back('\n');
+            if (!result) {
+                return;
+            }
+            const int rows = PQntuples(result);
+            const int fields = PQnfields(result);
+            m_line.append((boost::format("result\t%1%\t%2%\t%3%\n") % static_cast<int>(PQresultStatus(result)) % rows
+                    % fields).str());
+            for (int f = 0; f < fields; ++f) {
+                m_line.append("field");
+                add_argument(PQfname(result, f));
+                m_line.append((boost::format("\t%1%\t%2%\n") % PQftype(result, f) % PQfformat(result, f)).str());
+            }
+            for (int r = 0; r < rows; ++r) {
+                m_line.append("row");
+                for (int f = 0; f < fields; ++f) {
+                    m_line.push_back('\t');
+                    if (PQgetisnull(result, r, f)) {
+                        m_line.append("\\N");
+                    } else {
+                        detail::append_escaped(PQgetvalue(result, r, f), PQgetlength(result, r, f), m_line);
+                    }
+                }
+                m_line.push_back('\n');
+            }
+        }
+
+        void write_record() {
+            if (m_line.back() != '\n') {
+                m_line.push_back('\n');
+            }
+            m_out.write(m_line.data(), m_line.size());
+            if (!m_out) {
+                throw std::runtime_error((boost::format("Writing the transport recording %1% failed.\n") % m_path).str());
+            }
+        }
+
+        static uint64_t elapsed_since(const std::chrono::steady_clock::time_point start) {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count());
+        }
+
+    public:
+        /**
+         * \param transport transport to forward the operations to, usually a LibpqTransport
+         * \param path file to record to, it is overwritten
+         *
+         * \throws std::runtime_error if the file cannot be opened
+         */
+        RecordingTransport(std::unique_ptr<Transport> transport, const std::string& path) :
+            m_transport(std::move(transport)),
+            m_path(path),
+            m_out(path, std::ios::binary | std::ios::trunc),
+            m_line() {
+            if (!m_out) {
+                throw std::runtime_error((boost::format("Cannot open transport recording %1%\n") % path).str());
+            }
+            m_out << detail::transport_recording_header << '\n';
+        }
+
+        const char* error_message() override {
+            return m_transport->error_message();
+        }
+
+        PGresult* exec(const char* command) override {
+            const auto start = std::chrono::steady_clock::now();
+            PGresult* result = m_transport->exec(command);
+            try {
+                start_record("exec", elapsed_since(start), result != nullptr);
+                add_argument(command);
+                add_result(result);
+                write_record();
+            } catch (...) {
+                // The caller never gets the result.
+                PQclear(result);
+                throw;
+            }
+            return result;
+        }
+
+        PGresult* prepare(const char* name, const char* query, const int params_count) override {
+            const auto start = std::chrono::steady_clock::now();
+            PGresult* result = m_transport->prepare(name, query, params_count);
+            try {
+                start_record("prepare", elapsed_since(start), result != nullptr);
+                add_argument(name);
+                add_argument(query);
+                add_argument(std::to_string(params_count).c_str());
+                add_result(result);
+                write_record();
+            } catch (...) {
+                PQclear(result);
+                throw;
+            }
+            return result;
+        }
+
+        PGresult* exec_prepared(const char* name, const int params_count, const char* const* param_values,
+                const int result_format) override {
+            const auto start = std::chrono::steady_clock::now();
+            PGresult* result = m_transport->exec_prepared(name, params_count, param_values, result_format);
+            try {
+                start_record("exec_prepared", elapsed_since(start), result != nullptr);
+                add_argument(name);
+                add_argument(std::to_string(result_format).c_str());
+                for (int i = 0; i < params_count; ++i) {
+                    add_argument(param_values[i]);
+                }
+                add_result(result);
+                write_record();
+            } catch (...) {
+                PQclear(result);
+                throw;
+            }
+            return result;
+        }
+
+        int send_query(const char* query) override {
+            const auto start = std::chrono::steady_clock::now();
+            const int return_value = m_transport->send_query(query);
+            start_record("send_query", elapsed_since(start), return_value);
+            add_argument(query);
+            write_record();
+            return return_value;
+        }
+
+        PGresult* get_result() override {
+            const auto start = std::chrono::steady_clock::now();
+            PGresult* result = m_transport->get_result();
+            try {
+                start_record("get_result", elapsed_since(start), result != nullptr);
+                add_result(result);
+                write_record();
+            } catch (...) {
+                PQclear(result);
+                throw;
+            }
+            return result;
+        }
+
+        int put_copy_data(const char* data, const int size) override {
+            const auto start = std::chrono::steady_clock::now();
+            const int return_value = m_transport->put_copy_data(data, size);
+            start_record("put_copy_data", elapsed_since(start), return_value);
+            add_argument(std::to_string(size).c_str());
+            write_record();
+            return return_value;
+        }
+
+        int put_copy_end(const char* error_message) override {
+            const auto start = std::chrono::steady_clock::now();
+            const int return_value = m_transport->put_copy_end(error_message);
+            start_record("put_copy_end", elapsed_since(start), return_value);
+            write_record();
+            return return_value;
+        }
+
+        int flush() override {
+            return m_transport->flush();
+        }
+
+        int set_nonblocking(const bool nonblocking) override {
+            return m_transport->set_nonblocking(nonblocking);
+        }
+
+        int socket() override {
+            return m_transport->socket();
+        }
+
+        int consume_input() override {
+            return m_transport->consume_input();
+        }
+
+        PGconn* connection() override {
+            return m_transport->connection();
+        }
+    };
+
+    /**
+     * \brief Transport which plays a recording of a RecordingTransport back without a database.
+     *
+     * The operations have to be called in the recorded order, otherwise an exception is thrown.
+     * Only the name (prepared statements) or the SQL (other queries) is compared, not the parameters.
+     * The splitting of the COPY data may differ from the recording (e.g. if the buffer size is
+     * different), the recorded time spent in `put_copy_data` is waited for before the next
+     * operation.
+     *
+     * Each operation returning a result waits for its recorded duration multiplied by
+     * `latency_factor` plus `added_latency` before the recorded result is returned. Use a factor of
+     * 0 to measure the client side only. Waits are accumulated until they reach 1 ms, and time slept
+     * too long is deducted from the following waits. Thus, the total time waited matches the
+     * recording even if the single operations are much faster than the granularity of sleeping.
+     */
+    class ReplayTransport : public Transport {
+
+        std::string m_path;
+
+        std::ifstream m_in;
+
+        size_t m_line_number = 0;
+
+        std::string m_line;
+
+        std::vector<detail::RecordedField> m_fields;
+
+        std::string m_error_message;
+
+        double m_latency_factor;
+
+        uint64_t m_added_latency;
+
+        /// recorded time spent in put_copy_data which has not been waited for yet
+        uint64_t m_copy_latency = 0;
+
+        /// time in nanoseconds to be waited for but not waited for yet, negative if a sleep took too long
+        int64_t m_latency_debt = 0;
+
+        /// shorter waits are accumulated because sleeping takes longer than requested
+        static constexpr int64_t min_sleep = 1000000;
+
+        bool read_line() {
+            if (!std::getline(m_in, m_line)) {
+                return false;
+            }
+            ++m_line_number;
+            detail::split_recorded_line(m_line, m_fields);
+            return true;
+        }
+
+        std::runtime_error diverged(const char* operation, const char* argument) {
+            return std::runtime_error((boost::format("Replay of %1% diverged at line %2%: expected %3% %4%, recorded %5%\n")
+                    % m_path % m_line_number % operation % argument % m_line.substr(0, 200)).str());
+        }
+
+        void wait(const uint64_t nanoseconds) {
+            m_latency_debt += static_cast<int64_t>(nanoseconds * m_latency_factor + m_added_latency);
+            if (m_latency_debt < min_sleep) {
+                return;
+            }
+            const auto start = std::chrono::steady_clock::now();
+            std::this_thread::sleep_for(std::chrono::nanoseconds(m_latency_debt));
+            m_latency_debt -= std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+        }
+
+        /**
+         * Read the next operation (skipping COPY data) and check that it is the expected one.
+         *
+         * \returns return value of the operation
+         */
+        int next_operation(const char* operation, const char* argument = nullptr) {
+            while (read_line()) {
+                if (m_fields.size() < 4) {
+                    throw std::runtime_error((boost::format("Invalid record in %1% at line %2%\n") % m_path
+                            % m_line_number).str());
+                }
+                const uint64_t duration = std::strtoull(m_fields[1].value.c_str(), nullptr, 10);
+                if (m_fields[0].value == "put_copy_data") {
+                    m_copy_latency += duration;
+                    continue;
+                }
+                if (m_fields[0].value != operation || (argument && (m_fields.size() < 5 || m_fields[4].value != argument))) {
+                    throw diverged(operation, argument ? argument : "");
+                }
+                m_error_message = m_fields[3].value;
+                wait(m_copy_latency + duration);
+                m_copy_latency = 0;
+                return std::atoi(m_fields[2].value.c_str());
+            }
+            throw diverged(operation, argument ? argument : "");
+        }
+
+        /**
+         * Read the result of the current operation.
+         */
+        PGresult* read_result(const int has_result) {
+            if (!has_result) {
+                return nullptr;
+            }
+            if (!read_line() || m_fields.size() != 4 || m_fields[0].value != "result") {
+                throw std::runtime_error((boost::format("Invalid result in %1% at line %2%\n") % m_path
+                        % m_line_number).str());
+            }
+            const ExecStatusType status = static_cast<ExecStatusType>(std::atoi(m_fields[1].value.c_str()));
+            const int rows = std::atoi(m_fields[2].value.c_str());
+            const int field_count = std::atoi(m_fields[3].value.c_str());
+            std::unique_ptr<PGresult, decltype(&PQclear)> result{PQmakeEmptyPGresult(nullptr, status), &PQclear};
+            std::vector<std::string> names;
+            std::vector<PGresAttDesc> attributes(field_count);
+            for (int f = 0; f < field_count; ++f) {
+                if (!read_line() || m_fields.size() != 4 || m_fields[0].value != "field") {
+                    throw std::runtime_error((boost::format("Invalid field in %1% at line %2%\n") % m_path
+                            % m_line_number).str());
+                }
+                names.push_back(m_fields[1].value);
+                attributes[f].tableid = 0;
+                attributes[f].columnid = 0;
+                attributes[f].typid = static_cast<Oid>(std::strtoul(m_fields[2].value.c_str(), nullptr, 10));
+                attributes[f].format = std::atoi(m_fields[3].value.c_str());
+                attributes[f].typlen = -1;
+                attributes[f].atttypmod = -1;
+            }
+            for (int f = 0; f < field_count; ++f) {
+                attributes[f].name = const_cast<char*>(names[f].c_str());
+            }
+            if (field_count > 0 && !PQsetResultAttrs(result.get(), field_count, attributes.data())) {
+                throw std::runtime_error("PQsetResultAttrs failed\n");
+            }
+            for (int r = 0; r < rows; ++r) {
+                if (!read_line() || static_cast<int>(m_fields.size()) != field_count + 1 || m_fields[0].value != "row") {
+                    throw std::runtime_error((boost::format("Invalid row in %1% at line %2%\n") % m_path
+                            % m_line_number).str());
+                }
+                for (int f = 0; f < field_count; ++f) {
+                    const detail::RecordedField& field = m_fields[f + 1];
+                    // PQsetvalue copies the value, a length of -1 means NULL
+                    if (!PQsetvalue(result.get(), r, f, field.null ? nullptr : const_cast<char*>(field.value.data()),
+                            field.null ? -1 : static_cast<int>(field.value.size()))) {
+                        throw std::runtime_error("PQsetvalue failed\n");
+                    }
+                }
+            }
+            return result.release();
+        }
+
+    public:
+        /**
+         * \param path recording written by RecordingTransport
+         * \param latency_factor factor applied to the recorded durations
+         * \param added_latency latency in nanoseconds added to each operation
+         *
+         * \throws std::runtime_error if the file cannot be read
+         */
+        explicit ReplayTransport(const std::string& path, const double latency_factor = 1.0,
+                const uint64_t added_latency = 0) :
+            m_path(path),
+            m_in(path, std::ios::binary),
+            m_line(),
+            m_fields(),
+            m_error_message(),
+            m_latency_factor(latency_factor),
+            m_added_latency(added_latency) {
+            if (!m_in || !std::getline(m_in, m_line) || m_line != detail::transport_recording_header) {
+                throw std::runtime_error((boost::format("%1% is not a transport recording.\n") % path).str());
+            }
+            ++m_line_number;
+        }
+
+        const char* error_message() override {
+            return m_error_message.c_str();
+        }
+
+        PGresult* exec(const char* command) override {
+            return read_result(next_operation("exec", command));
+        }
+
+        PGresult* prepare(const char* name, const char* /* query */, const int /* params_count */) override {
+            return read_result(next_operation("prepare", name));
+        }
+
+        PGresult* exec_prepared(const char* name, const int /* params_count */, const char* const* /* param_values */,
+                const int /* result_format */) override {
+            return read_result(next_operation("exec_prepared", name));
+        }
+
+        int send_query(const char* query) override {
+            return next_operation("send_query", query);
+        }
+
+        PGresult* get_result() override {
+            return read_result(next_operation("get_result"));
+        }
+
+        int put_copy_data(const char* /* data */, const int /* size */) override {
+            return 1;
+        }
+
+        int put_copy_end(const char* /* error_message */) override {
+            return next_operation("put_copy_end");
+        }
+
+        int flush() override {
+            return 0;
+        }
+
+        int set_nonblocking(const bool /* nonblocking */) override {
+            return 0;
+        }
+
+        int socket() override {
+            return -1;
+        }
+
+        int consume_input() override {
+            return 1;
+        }
+
+        PGconn* connection() override {
+            return nullptr;
+        }
+    };
+}
+
+#endif /* INCLUDE_POSTGRES_DRIVERS_TRANSPORT_RECORDING_HPP_ */
@@ -0,0 +1,145 @@
+/*
+ * user_dictionary.hpp
+ *
+ *  Created on:  2026-10-18
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ */
+
+#ifndef INCLUDE_POSTGRES_DRIVERS_USER_DICTIONARY_HPP_
+#define INCLUDE_POSTGRES_DRIVERS_USER_DICTIONARY_HPP_
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+
+#include <boost/format.hpp>
+
+#include "columns.hpp"
+#include "copy_encoding.hpp"
+#include "table.hpp"
+
+namespace postgres_drivers {
+
+    /**
+     * \brief Dictionary of user names used by Config::compact_metadata.
+     *
+     * Object tables only store the user ID, the names are stored once per user in a table with the
+     * columns `uid` and `name`. Names which have already been written are remembered, so each user
+     * is written only once during an import.
+     *
+     * During an import (COPY mode of the table), new users are added using COPY. The first name
+     * seen for a user wins. Create the primary key after the import. Otherwise (diff updates),
+     * users are inserted or renamed using a prepared statement.
+     */
+    class UserDictionary {
+
+        Table& m_table;
+
+        std::unordered_map<uint32_t, std::string> m_names;
+
+        std::string m_line;
+
+        bool m_statements_prepared = false;
+
+    public:
+        /**
+         * \param table table of the dictionary, create it with the columns returned by columns()
+         */
+        explicit UserDictionary(Table& table) :
+            m_table(table),
+            m_names(),
+            m_line() {
+        }
+
+        /**
+         * \brief Get the columns of the dictionary table.
+         */
+        static Columns columns() {
+            return Columns{ColumnsVector{
+                Column{"uid", ColumnType::INT, ColumnClass::UID},
+                Column{"name", ColumnType::TEXT, ColumnClass::USERNAME}
+            }, TableType::OTHER};
+        }
+
+        /**
+         * \brief Create the prepared statements used outside of COPY mode and by get().
+         *
+         * The table needs a primary key or unique index on `uid`.
+         */
+        void create_prepared_statements() {
+            std::string query = (boost::format("INSERT INTO %1% (uid, name) VALUES ($1, $2) ON CONFLICT (uid) "
+                    "DO UPDATE SET name = EXCLUDED.name WHERE %1%.name <> EXCLUDED.name") % m_table.get_name()).str();
+            m_table.create_prepared_statement("upsert_user", query, 2);
+            query = (boost::format("SELECT name FROM %1% WHERE uid = $1") % m_table.get_name()).str();
+            m_table.create_prepared_statement("get_user_name", query, 1);
+            m_statements_prepared = true;
+        }
+
+        /**
+         * \brief Add a user if it is unknown or its name has changed.
+         *
+         * \param uid user ID, 0 (anonymous) is ignored
+         * \param name user name
+         *
+         * \throws std::runtime_error
+         */
+        void add(const uint32_t uid, const char* name) {
+            if (uid == 0) {
+                return;
+            }
+            auto it = m_names.find(uid);
+            if (m_table.get_copy()) {
+                if (it != m_names.end()) {
+                    return;
+                }
+                m_line = std::to_string(uid);
+                m_line.push_back('\t');
+                escape(name, m_line);
+                m_line.push_back('\n');
+                m_table.send_line(m_line);
+            } else {
+                if (it != m_names.end() && it->second == name) {
+                    return;
+                }
+                const std::string uid_str = std::to_string(uid);
+                const char* const param_values[] = {uid_str.c_str(), name};
+                PQclear(m_table.send_prepared_query("upsert_user", 2, param_values));
+            }
+            m_names[uid] = name;
+        }
+
+        /**
+         * \brief Get the name of a user.
+         *
+         * \returns name or an empty string if the user is unknown
+         *
+         * \throws std::runtime_error
+         */
+        std::string get(const uint32_t uid) {
+            auto it = m_names.find(uid);
+            if (it != m_names.end() || !m_statements_prepared) {
+                return it == m_names.end() ? "" : it->second;
+            }
+            const std::string uid_str = std::to_string(uid);
+            const char* const param_values[] = {uid_str.c_str()};
+            PGresult* result = m_table.send_prepared_query("get_user_name", 1, param_values);
+            std::string name;
+            if (PQntuples(result) == 1) {
+                name = PQgetvalue(result, 0, 0);
+                m_names[uid] = name;
+            }
+            PQclear(result);
+            return name;
+        }
+
+        /**
+         * \brief Number of users known to this object.
+         */
+        size_t size() const noexcept {
+            return m_names.size();
+        }
+    };
+}
+
+#endif /* INCLUDE_POSTGRES_DRIVERS_USER_DICTIONARY_HPP_ */
@@ -0,0 +1,142 @@
+/*
+ * fake_transport.hpp
+ *
+ *  Created on:  2026-10-18
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ *
+ *  Transport for tests which answers all operations without a database and keeps a log of them.
+ */
+
+#ifndef TESTS_FAKE_TRANSPORT_HPP_
+#define TESTS_FAKE_TRANSPORT_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <postgres_drivers/transport.hpp>
+
+namespace test {
+
+    inline void check(const bool condition, const std::string& message) {
+        if (!condition) {
+            std::cerr << "FAILED: " << message << '\n';
+            std::exit(1);
+        }
+    }
+
+    /**
+     * Transport answering every query successfully. COPY data is collected in #copied.
+     */
+    class FakeTransport : public postgres_drivers::Transport {
+
+    public:
+        /// commands passed to exec() and send_query()
+        std::vector<std::string> queries;
+
+        /// prepared statements by name
+        std::map<std::string, std::string> prepared;
+
+        /// names of the executed prepared statements
+        std::vector<std::string> executed;
+
+        std::string copied;
+
+        /// number of results get_result() returns before it returns a nullpointer
+        int pending_results = 0;
+
+        /// time each call of put_copy_data() takes
+        std::chrono::milliseconds copy_delay{0};
+
+        /// set while put_copy_data() is running
+        std::atomic<bool> copying{false};
+
+        /// set if this transport was destroyed while put_copy_data() was running
+        static std::atomic<bool>& destroyed_while_copying() {
+            static std::atomic<bool> flag{false};
+            return flag;
+        }
+
+        ~FakeTransport() {
+            if (copying) {
+                destroyed_while_copying() = true;
+            }
+        }
+
+        const char* error_message() override {
+            return "";
+        }
+
+        PGresult* exec(const char* command) override {
+            queries.push_back(command);
+            return PQmakeEmptyPGresult(nullptr, std::strncmp(command, "COPY", 4) == 0 ? PGRES_COPY_IN : PGRES_COMMAND_OK);
+        }
+
+        PGresult* prepare(const char* name, const char* query, const int) override {
+            prepared[name] = query;
+            return PQmakeEmptyPGresult(nullptr, PGRES_COMMAND_OK);
+        }
+
+        PGresult* exec_prepared(const char* name, const int, const char* const*, const int) override {
+            executed.push_back(name);
+            return PQmakeEmptyPGresult(nullptr, PGRES_TUPLES_OK);
+        }
+
+        int send_query(const char* query) override {
+            queries.push_back(query);
+            ++pending_results;
+            return 1;
+        }
+
+        PGresult* get_result() override {
+            if (pending_results == 0) {
+                return nullptr;
+            }
+            --pending_results;
+            return PQmakeEmptyPGresult(nullptr, PGRES_COMMAND_OK);
+        }
+
+        int put_copy_data(const char* data, const int size) override {
+            copying = true;
+            if (copy_delay.count() > 0) {
+                std::this_thread::sleep_for(copy_delay);
+            }
+            copied.append(data, size);
+            copying = false;
+            return 1;
+        }
+
+        int put_copy_end(const char*) override {
+            ++pending_results;
+            return 1;
+        }
+
+        int flush() override {
+            return 0;
+        }
+
+        int set_nonblocking(const bool) override {
+            return 0;
+        }
+
+        int socket() override {
+            return -1;
+        }
+
+        int consume_input() override {
+            return 1;
+        }
+
+        PGconn* connection() override {
+            return nullptr;
+        }
+    };
+}
+
+#endif /* TESTS_FAKE_TRANSPORT_HPP_ */
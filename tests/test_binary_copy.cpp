@@ -0,0 +1,154 @@
+/*
+ * test_binary_copy.cpp
+ *
+ *  Created on:  2026-10-18
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ *
+ *  Tests of the binary format of COPY: encoding of rows by BinaryCopyRow, counting of rows and the
+ *  header and trailer added by Table.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <postgres_drivers/binary_copy.hpp>
+#include <postgres_drivers/copy_sink.hpp>
+#include <postgres_drivers/table.hpp>
+
+#include "fake_transport.hpp"
+
+using namespace postgres_drivers;
+using test::check;
+
+namespace {
+
+    struct Tag {
+        const char* k;
+        const char* v;
+
+        const char* key() const noexcept {
+            return k;
+        }
+
+        const char* value() const noexcept {
+            return v;
+        }
+    };
+
+    /**
+     * Sink keeping all COPY data in memory.
+     */
+    class MemorySink : public CopySink {
+
+        std::string& m_data;
+
+    public:
+        explicit MemorySink(std::string& data) :
+            m_data(data) {
+        }
+
+        void start(const std::string&, const CopyFormat) override {
+        }
+
+        void write(const char* data, const size_t size) override {
+            m_data.append(data, size);
+        }
+
+        void end() override {
+        }
+    };
+
+    std::string bytes(const char* data, const size_t size) {
+        return std::string(data, size);
+    }
+
+    void test_encoding() {
+        std::string row;
+        BinaryCopyRow encoder{row, 7};
+        encoder.add_null();
+        encoder.add_int2(-2);
+        encoder.add_int4(0x01020304);
+        encoder.add_int8(-1);
+        // one second after 2000-01-01 00:00:00 UTC
+        encoder.add_timestamptz(946684801);
+        encoder.add_text("ab");
+        encoder.add_hstore(std::vector<Tag>{{"k", "v"}, {"key", ""}});
+        const std::string expected = bytes("\0\x07", 2)
+                + bytes("\xff\xff\xff\xff", 4)
+                + bytes("\0\0\0\x02" "\xff\xfe", 6)
+                + bytes("\0\0\0\x04" "\x01\x02\x03\x04", 8)
+                + bytes("\0\0\0\x08" "\xff\xff\xff\xff\xff\xff\xff\xff", 12)
+                + bytes("\0\0\0\x08" "\0\0\0\0\0\x0f\x42\x40", 12)
+                + bytes("\0\0\0\x02" "ab", 6)
+                // length, number of pairs, then length and bytes of each key and value
+                + bytes("\0\0\0\x19" "\0\0\0\x02", 8)
+                + bytes("\0\0\0\x01" "k" "\0\0\0\x01" "v", 10)
+                + bytes("\0\0\0\x03" "key" "\0\0\0\0", 11);
+        check(row == expected, "wrong encoding of a row");
+
+        std::string empty;
+        BinaryCopyRow{empty, 1}.add_hstore(std::vector<Tag>{});
+        check(empty == bytes("\0\x01" "\0\0\0\x04" "\0\0\0\0", 10), "wrong encoding of an empty hstore");
+    }
+
+    void test_count_rows() {
+        std::string rows;
+        for (int i = 0; i < 3; ++i) {
+            BinaryCopyRow encoder{rows, 3};
+            encoder.add_int8(i);
+            encoder.add_null();
+            encoder.add_hstore(std::vector<Tag>{{"name", "x"}});
+        }
+        check(count_binary_copy_rows(rows.data(), rows.size()) == 3, "wrong number of rows");
+        check(count_binary_copy_rows(rows.data(), 0) == 0, "rows found in empty data");
+
+        const std::string stream = binary_copy_header() + rows + bytes("\xff\xff", 2);
+        check(count_binary_copy_rows(stream.data(), stream.size()) == 3, "header or trailer counted as rows");
+
+        // header with an extension of 4 bytes
+        std::string extended = binary_copy_header();
+        extended[18] = '\x04';
+        extended.append("abcd");
+        extended.append(rows);
+        check(count_binary_copy_rows(extended.data(), extended.size()) == 3, "header extension not skipped");
+    }
+
+    void test_table() {
+        Config config;
+        config.collect_stats = true;
+        Columns columns{ColumnsVector{Column{"uid", ColumnType::BIGINT, ColumnClass::UID},
+                Column{"name", ColumnType::TEXT, ColumnClass::USERNAME}}, TableType::OTHER};
+        std::string rows;
+        for (int i = 0; i < 2; ++i) {
+            BinaryCopyRow encoder{rows, 2};
+            encoder.add_int8(i);
+            encoder.add_null();
+        }
+
+        test::FakeTransport* transport = new test::FakeTransport();
+        Table table{"users", config, columns, std::unique_ptr<Transport>{transport}};
+        table.start_copy(CopyFormat::BINARY);
+        table.send_line(rows);
+        table.end_copy();
+        check(transport->queries.back().find("(FORMAT binary)") != std::string::npos, "COPY not in binary format");
+        check(transport->copied == binary_copy_header() + rows + bytes("\xff\xff", 2),
+                "header or trailer missing in the COPY stream");
+        check(table.stats().rows == 2, "wrong number of rows in the statistics");
+
+        // Offline dumps are loaded in chunks, they have no trailer.
+        std::string dump;
+        Table offline{"users", config, columns, std::unique_ptr<CopySink>{new MemorySink(dump)}};
+        offline.start_copy(CopyFormat::BINARY);
+        offline.send_line(rows);
+        offline.end_copy();
+        check(dump == binary_copy_header() + rows, "trailer written to an offline dump");
+    }
+}
+
+int main() {
+    test_encoding();
+    test_count_rows();
+    test_table();
+    std::cout << "all tests passed\n";
+}
@@ -0,0 +1,218 @@
+/*
+ * test_concurrent_writer.cpp
+ *
+ *  Created on:  2026-10-18
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ *
+ *  Multi-producer stress test of the lock-free queue and of ConcurrentWriter in unordered and
+ *  ordered mode. The writer is used with a table which collects the lines in memory, i.e. no
+ *  database is necessary.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <postgres_drivers/concurrent_writer.hpp>
+
+using postgres_drivers::ConcurrentWriter;
+namespace detail = postgres_drivers::detail;
+
+namespace {
+
+    constexpr int producers = 8;
+
+    void check(const bool condition, const std::string& message) {
+        if (!condition) {
+            std::cerr << "FAILED: " << message << '\n';
+            std::exit(1);
+        }
+    }
+
+    /**
+     * Table collecting all lines. It tracks how many committed buffers have not been written yet.
+     */
+    class MemoryTable {
+
+        std::atomic<size_t>& m_committed;
+
+        size_t m_max_pending = 0;
+
+    public:
+        std::vector<uint64_t> lines;
+
+        bool copy_mode = false;
+
+        explicit MemoryTable(std::atomic<size_t>& committed) :
+            m_committed(committed),
+            lines() {
+        }
+
+        void start_copy() {
+            copy_mode = true;
+        }
+
+        void send_line(const std::string& data) {
+            check(copy_mode, "send_line outside of COPY");
+            std::istringstream stream{data};
+            uint64_t value;
+            size_t count = 0;
+            while (stream >> value) {
+                lines.push_back(value);
+                ++count;
+            }
+            m_max_pending = std::max(m_max_pending, m_committed.load() - lines.size() + count);
+            if (lines.size() % 64 == 0) {
+                // slow consumer
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        }
+
+        void end_copy() {
+            copy_mode = false;
+        }
+
+        size_t max_pending() const noexcept {
+            return m_max_pending;
+        }
+    };
+
+    void test_queue() {
+        constexpr uint64_t per_producer = 200000;
+        detail::MPSCQueue queue;
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&queue, p]() {
+                for (uint64_t i = 0; i < per_producer; ++i) {
+                    detail::WriterNode* node = new detail::WriterNode();
+                    node->sequence = (static_cast<uint64_t>(p) << 32) | i;
+                    queue.push(node);
+                }
+            });
+        }
+        std::vector<uint64_t> next(producers, 0);
+        uint64_t received = 0;
+        while (received < producers * per_producer) {
+            detail::WriterNode* node = queue.pop();
+            if (!node) {
+                std::this_thread::yield();
+                continue;
+            }
+            const uint64_t p = node->sequence >> 32;
+            const uint64_t i = node->sequence & 0xffffffff;
+            check(p < producers, "queue returned a foreign node");
+            check(i == next[p], "queue reordered the nodes of a producer");
+            ++next[p];
+            ++received;
+            delete node;
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        check(queue.pop() == nullptr, "queue not empty after all nodes were received");
+    }
+
+    void test_unordered() {
+        constexpr uint64_t per_producer = 50000;
+        std::atomic<size_t> committed{0};
+        MemoryTable table{committed};
+        {
+            ConcurrentWriter<MemoryTable> writer{table, 256, false, 4};
+            std::vector<std::thread> threads;
+            for (int p = 0; p < producers; ++p) {
+                threads.emplace_back([&writer, p]() {
+                    auto producer = writer.producer();
+                    for (uint64_t i = 0; i < per_producer; ++i) {
+                        producer.send_line(std::to_string(p * per_producer + i) + '\n');
+                    }
+                    producer.flush();
+                });
+            }
+            for (auto& thread : threads) {
+                thread.join();
+            }
+            writer.finish();
+        }
+        check(!table.copy_mode, "COPY not ended");
+        std::sort(table.lines.begin(), table.lines.end());
+        check(table.lines.size() == producers * per_producer, "lines lost or duplicated");
+        for (uint64_t i = 0; i < table.lines.size(); ++i) {
+            check(table.lines[i] == i, "lines lost or duplicated");
+        }
+    }
+
+    void test_ordered() {
+        constexpr uint64_t sequences = 20000;
+        constexpr size_t max_queued = 4;
+        std::atomic<size_t> committed{0};
+        MemoryTable table{committed};
+        {
+            ConcurrentWriter<MemoryTable> writer{table, 256, true, max_queued};
+            std::atomic<uint64_t> next_input{0};
+            std::vector<std::thread> threads;
+            for (int p = 0; p < producers; ++p) {
+                threads.emplace_back([&writer, &next_input, &committed, p]() {
+                    auto producer = writer.producer();
+                    unsigned int delay = p;
+                    for (uint64_t sequence = next_input++; sequence < sequences; sequence = next_input++) {
+                        // Some input buffers take much longer to process than others.
+                        delay = delay * 1103515245 + 12345;
+                        if ((delay >> 16) % 16 == 0) {
+                            std::this_thread::sleep_for(std::chrono::microseconds((delay >> 8) % 500));
+                        }
+                        producer.send_line(std::to_string(sequence) + '\n');
+                        ++committed;
+                        producer.commit(sequence);
+                    }
+                });
+            }
+            for (auto& thread : threads) {
+                thread.join();
+            }
+            writer.finish();
+        }
+        check(table.lines.size() == sequences, "lines lost or duplicated");
+        for (uint64_t i = 0; i < table.lines.size(); ++i) {
+            check(table.lines[i] == i, "lines not written in the order of their sequence numbers");
+        }
+        // Every producer may have one buffer in the queue beyond the limit and one it is about to commit.
+        check(table.max_pending() <= max_queued + 2 * producers, "reorder buffer not bounded by max_queued");
+    }
+
+    void test_ordered_uncommitted() {
+        std::atomic<size_t> committed{0};
+        MemoryTable table{committed};
+        ConcurrentWriter<MemoryTable> writer{table, 256, true, 4};
+        std::thread thread{[&writer]() {
+            auto producer = writer.producer();
+            producer.send_line("0\n");
+            producer.commit(0);
+            // never committed
+            producer.send_line("1\n");
+        }};
+        thread.join();
+        bool failed = false;
+        try {
+            writer.finish();
+        } catch (const std::runtime_error&) {
+            failed = true;
+        }
+        check(failed, "finish() succeeded although lines were not committed");
+        check(table.copy_mode, "COPY ended although lines were lost");
+    }
+}
+
+int main() {
+    test_queue();
+    test_unordered();
+    test_ordered();
+    test_ordered_uncommitted();
+    std::cout << "all tests passed\n";
+}
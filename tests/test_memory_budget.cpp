@@ -0,0 +1,92 @@
+/*
+ * test_memory_budget.cpp
+ *
+ *  Created on:  2026-10-18
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ *
+ *  Tests of MemoryBudget: consumers which are removed while another thread releases their memory,
+ *  also as Tables destroyed while another thread flushes their COPY buffer.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <postgres_drivers/memory_budget.hpp>
+#include <postgres_drivers/table.hpp>
+
+#include "fake_transport.hpp"
+
+using namespace postgres_drivers;
+using test::check;
+
+namespace {
+
+    void wait_for(const std::atomic<bool>& flag) {
+        while (!flag) {
+            std::this_thread::yield();
+        }
+    }
+
+    void test_remove_waits_for_release() {
+        MemoryBudget budget{300, 1000000};
+        std::atomic<bool> started{false};
+        std::atomic<bool> finished{false};
+        const size_t victim = budget.add_consumer([&]() {
+            started = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            finished = true;
+        });
+        const size_t other = budget.add_consumer([]() {});
+        budget.update(victim, 250);
+        // exceeds the soft limit, the victim is released by this thread
+        std::thread thread{[&]() {
+            budget.update(other, 100);
+        }};
+        wait_for(started);
+        budget.remove_consumer(victim);
+        check(finished, "remove_consumer() returned while the release callback was running");
+        thread.join();
+        check(budget.usage() == 100, "usage of the removed consumer not subtracted");
+    }
+
+    void test_destroy_table_while_flushing() {
+        MemoryBudget budget{300, 1000000};
+        Config config;
+        config.copy_buffer_size = 1024 * 1024;
+        config.memory_budget = &budget;
+        Columns columns{ColumnsVector{Column{"uid", ColumnType::INT, ColumnClass::UID}}, TableType::OTHER};
+        const std::string large_line = std::string(250, '1') + '\n';
+        const std::string small_line = std::string(100, '2') + '\n';
+        for (int i = 0; i < 50; ++i) {
+            test::FakeTransport* victim_transport = new test::FakeTransport();
+            victim_transport->copy_delay = std::chrono::milliseconds(2);
+            std::unique_ptr<Table> victim{new Table("victim", config, columns,
+                    std::unique_ptr<Transport>{victim_transport})};
+            test::FakeTransport* other_transport = new test::FakeTransport();
+            Table other{"other", config, columns, std::unique_ptr<Transport>{other_transport}};
+            victim->start_copy();
+            victim->send_line(large_line);
+            other.start_copy();
+            // exceeds the soft limit, the buffer of the victim is flushed by this thread
+            std::thread thread{[&]() {
+                other.send_line(small_line);
+                other.end_copy();
+            }};
+            wait_for(victim_transport->copying);
+            victim.reset();
+            thread.join();
+            check(other_transport->copied == small_line, "COPY data of the other table lost");
+        }
+        check(!test::FakeTransport::destroyed_while_copying(), "table destroyed while its buffer was flushed");
+        check(budget.usage() == 0, "usage of destroyed tables not subtracted");
+    }
+}
+
+int main() {
+    test_remove_waits_for_release();
+    test_destroy_table_while_flushing();
+    std::cout << "all tests passed\n";
+}
@@ -0,0 +1,64 @@
+/*
+ * test_node_locations.cpp
+ *
+ *  Created on:  2026-10-18
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ *
+ *  Tests of TableNodeLocations using a fake connection: COPY is only used by imports, diffs replace
+ *  the row of a node using prepared statements.
+ */
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <postgres_drivers/node_locations.hpp>
+
+#include "fake_transport.hpp"
+
+using namespace postgres_drivers;
+using test::check;
+
+namespace {
+
+    void test_import() {
+        Config config;
+        test::FakeTransport* transport = new test::FakeTransport();
+        Table table{"untagged_nodes", config, Columns{config, TableType::UNTAGGED_POINT},
+                std::unique_ptr<Transport>{transport}};
+        TableNodeLocations locations{table, true};
+        table.start_copy();
+        locations.set(42, osmium::Location{10, 20});
+        table.end_copy();
+        check(transport->copied.find("42\t") == 0, "location not written using COPY");
+        check(transport->executed.empty(), "prepared statement executed during an import");
+    }
+
+    void test_diff() {
+        Config config;
+        test::FakeTransport* transport = new test::FakeTransport();
+        Table table{"untagged_nodes", config, Columns{config, TableType::UNTAGGED_POINT},
+                std::unique_ptr<Transport>{transport}};
+        TableNodeLocations locations{table};
+        locations.set(42, osmium::Location{10, 20});
+        check(transport->executed.size() == 2 && transport->executed[0] == "delete_statement"
+                && transport->executed[1] == "insert_untagged_node", "old row of the node not deleted");
+
+        table.start_copy();
+        bool failed = false;
+        try {
+            locations.set(42, osmium::Location{30, 40});
+        } catch (const std::runtime_error&) {
+            failed = true;
+        }
+        table.end_copy();
+        check(failed, "location replaced using COPY outside of an import");
+        check(transport->copied.empty(), "row appended using COPY outside of an import");
+    }
+}
+
+int main() {
+    test_import();
+    test_diff();
+    std::cout << "all tests passed\n";
+}
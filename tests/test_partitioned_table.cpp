@@ -0,0 +1,153 @@
+/*
+ * test_partitioned_table.cpp
+ *
+ *  Created on:  2026-10-18
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ *
+ *  Tests of PartitionedTable using fake connections: prepared statements on the parent table,
+ *  partition bounds and routing of COPY data.
+ */
+
+#include <cstdlib>
+#include <initializer_list>
+#include <map>
+#include <memory>
+#include <string>
+
+#include <postgres_drivers/partitioned_table.hpp>
+
+#include "fake_transport.hpp"
+
+using namespace postgres_drivers;
+using test::check;
+
+namespace {
+
+    /**
+     * Creates fake connections and keeps track of them by table name.
+     */
+    struct Connections {
+        std::map<std::string, test::FakeTransport*> transports;
+
+        PartitionedTable::TransportFactory factory() {
+            return [this](const std::string& name) {
+                test::FakeTransport* transport = new test::FakeTransport();
+                transports[name] = transport;
+                return std::unique_ptr<Transport>{transport};
+            };
+        }
+    };
+
+    /**
+     * Get the IDs of a partition from its `FOR VALUES FROM (a) TO (b)` clause and check if it contains an ID.
+     */
+    bool bounds_contain(const std::string& bounds, const osmium::object_id_type id) {
+        const size_t from = bounds.find('(') + 1;
+        const size_t to = bounds.find('(', from) + 1;
+        const std::string lower = bounds.substr(from, bounds.find(')', from) - from);
+        const std::string upper = bounds.substr(to, bounds.find(')', to) - to);
+        return (lower == "MINVALUE" || std::strtoll(lower.c_str(), nullptr, 10) <= id)
+                && (upper == "MAXVALUE" || id < std::strtoll(upper.c_str(), nullptr, 10));
+    }
+
+    void test_prepared_statements() {
+        Config config;
+        config.partitions = 4;
+        config.partition_max_node_id = 1000;
+        Connections connections;
+        PartitionedTable table{"nodes", config, Columns{config, TableType::POINT}, connections.factory()};
+        table.create_prepared_statements();
+        const test::FakeTransport& parent = *connections.transports.at("nodes");
+        check(parent.prepared.count("delete_statement") == 1, "delete statement not prepared on the parent table");
+        check(parent.prepared.at("delete_statement") == "DELETE FROM nodes WHERE osm_id = $1",
+                "delete statement does not filter by the partition key");
+        check(parent.prepared.at("get_location_from_point_table").find("WHERE osm_id = $1") != std::string::npos,
+                "location lookup does not filter by the partition key");
+        check(table.scheme().key_column() == "osm_id", "wrong partition key");
+        for (size_t i = 0; i < table.scheme().size(); ++i) {
+            check(connections.transports.at(PartitionScheme::partition_name("nodes", i))->prepared.empty(),
+                    "statement prepared on a partition");
+        }
+
+        // PostgreSQL prunes `osm_id = $1` to the partitions whose bounds contain the value, there has
+        // to be exactly one.
+        for (const osmium::object_id_type id : std::initializer_list<osmium::object_id_type>{-5, 0, 1, 249, 250, 999, 1000,
+                5000000000}) {
+            int matches = 0;
+            for (size_t i = 0; i < table.scheme().size(); ++i) {
+                if (bounds_contain(table.scheme().bounds(i), id)) {
+                    ++matches;
+                    check(table.scheme().partition_of(id) == i, "COPY routing differs from the partition bounds");
+                }
+            }
+            check(matches == 1, "ID " + std::to_string(id) + " is not covered by exactly one partition");
+        }
+
+        table.parent().delete_object(42);
+        check(parent.executed.size() == 1 && parent.executed.front() == "delete_statement",
+                "prepared statement not executed on the parent table");
+    }
+
+    void test_text_routing() {
+        Config config;
+        config.partitions = 2;
+        config.partition_max_way_id = 100;
+        Connections connections;
+        Columns columns{ColumnsVector{Column{"name", ColumnType::TEXT, ColumnClass::TAGS_OTHER},
+                Column{"osm_id", ColumnType::BIGINT, ColumnClass::OSM_ID}}, TableType::OTHER};
+        PartitionedTable table{"t", config, columns, connections.factory()};
+        table.start_copy();
+        table.send_line("a\t1\nb\t70\n");
+        table.send_line("c\t49\n");
+        table.end_copy();
+        check(connections.transports.at("t_p0")->copied == "a\t1\nc\t49\n", "wrong rows in partition 0");
+        check(connections.transports.at("t_p1")->copied == "b\t70\n", "wrong rows in partition 1");
+        check(connections.transports.at("t")->copied.empty(), "rows sent to the parent table");
+    }
+
+    void test_binary_routing() {
+        Config config;
+        config.partitions = 2;
+        config.partition_max_way_id = 100;
+        Connections connections;
+        Columns columns{ColumnsVector{Column{"name", ColumnType::TEXT, ColumnClass::TAGS_OTHER},
+                Column{"osm_id", ColumnType::BIGINT, ColumnClass::OSM_ID}}, TableType::OTHER};
+        PartitionedTable table{"t", config, columns, connections.factory()};
+        std::string rows;
+        std::string expected0 = binary_copy_header();
+        std::string expected1 = binary_copy_header();
+        for (const osmium::object_id_type id : std::initializer_list<osmium::object_id_type>{3, 80, -2, 50}) {
+            std::string row;
+            BinaryCopyRow encoder{row, 2};
+            encoder.add_null();
+            encoder.add_int8(id);
+            (id < 50 ? expected0 : expected1).append(row);
+            rows.append(row);
+        }
+        expected0.append("\xff\xff", 2);
+        expected1.append("\xff\xff", 2);
+        table.start_copy(CopyFormat::BINARY);
+        table.send_line(rows);
+        check(connections.transports.at("t_p0")->queries.back().find("(FORMAT binary)") != std::string::npos,
+                "partition not in binary COPY mode");
+        table.end_copy();
+        check(connections.transports.at("t_p0")->copied == expected0, "wrong rows in partition 0");
+        check(connections.transports.at("t_p1")->copied == expected1, "wrong rows in partition 1");
+
+        table.start_copy(CopyFormat::BINARY);
+        bool failed = false;
+        try {
+            table.send_line(rows.substr(0, rows.size() - 3));
+        } catch (const std::runtime_error&) {
+            failed = true;
+        }
+        check(failed, "incomplete binary row accepted");
+    }
+}
+
+int main() {
+    test_prepared_statements();
+    test_text_routing();
+    test_binary_routing();
+    std::cout << "all tests passed\n";
+}
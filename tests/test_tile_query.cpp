@@ -0,0 +1,154 @@
+/*
+ * test_tile_query.cpp
+ *
+ *  Created on:  2026-10-18
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ *
+ *  Tests of TileQueryResult using results built on the client: grouping of the rows of several
+ *  batches by tile and decoding of values in binary format.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <postgres_drivers/tile_query.hpp>
+
+#include "fake_transport.hpp"
+
+using namespace postgres_drivers;
+using test::check;
+
+namespace {
+
+    /**
+     * Encode a number in the big endian binary format of PostgreSQL.
+     */
+    template <typename TValue, typename TUnsigned>
+    std::string big_endian(const TValue value) {
+        static_assert(sizeof(TValue) == sizeof(TUnsigned), "size of the unsigned type differs");
+        TUnsigned bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        std::string result(sizeof(bits), '\0');
+        for (size_t i = sizeof(bits); i > 0; --i) {
+            result[i - 1] = static_cast<char>(bits & 0xff);
+            bits = static_cast<TUnsigned>(bits >> 8);
+        }
+        return result;
+    }
+
+    struct Row {
+        int32_t tile;
+        /// integer of 2, 4 or 8 bytes
+        std::string id;
+        /// float4 or float8
+        std::string real;
+        /// NULL if empty
+        std::string name;
+    };
+
+    /**
+     * Build a result of a tile query with the columns tile, id, real and name.
+     */
+    PGresult* make_result(const std::vector<Row>& rows) {
+        PGresult* result = PQmakeEmptyPGresult(nullptr, PGRES_TUPLES_OK);
+        PGresAttDesc attributes[4] = {
+            {const_cast<char*>("tile"), 0, 0, 1, 23, 4, -1},
+            {const_cast<char*>("id"), 0, 0, 1, 20, 8, -1},
+            {const_cast<char*>("real"), 0, 0, 1, 701, 8, -1},
+            {const_cast<char*>("name"), 0, 0, 1, 25, -1, -1}
+        };
+        check(PQsetResultAttrs(result, 4, attributes), "PQsetResultAttrs failed");
+        for (size_t r = 0; r < rows.size(); ++r) {
+            const int row = static_cast<int>(r);
+            std::string tile = big_endian<int32_t, uint32_t>(rows[r].tile);
+            PQsetvalue(result, row, 0, &tile[0], 4);
+            std::string id = rows[r].id;
+            PQsetvalue(result, row, 1, &id[0], static_cast<int>(id.size()));
+            std::string real = rows[r].real;
+            PQsetvalue(result, row, 2, &real[0], static_cast<int>(real.size()));
+            std::string name = rows[r].name;
+            if (name.empty()) {
+                PQsetvalue(result, row, 3, nullptr, -1);
+            } else {
+                PQsetvalue(result, row, 3, &name[0], static_cast<int>(name.size()));
+            }
+        }
+        return result;
+    }
+
+    std::string int8(const int64_t value) {
+        return big_endian<int64_t, uint64_t>(value);
+    }
+
+    std::string float8(const double value) {
+        return big_endian<double, uint64_t>(value);
+    }
+
+    void test_read_big_endian() {
+        check(detail::read_big_endian<int16_t>(big_endian<int16_t, uint16_t>(-2).data()) == -2, "wrong int2");
+        check(detail::read_big_endian<int32_t>(big_endian<int32_t, uint32_t>(-70000).data()) == -70000, "wrong int4");
+        check(detail::read_big_endian<int64_t>(int8(-5000000000).data()) == -5000000000, "wrong int8");
+        check(detail::read_big_endian<int32_t>("\x01\x02\x03\x04") == 0x01020304, "wrong byte order");
+        check(detail::read_big_endian<float>(big_endian<float, uint32_t>(-1.5f).data()) == -1.5f, "wrong float4");
+        check(detail::read_big_endian<double>(float8(8.25e-300).data()) == 8.25e-300, "wrong float8");
+    }
+
+    void test_grouping() {
+        // tiles 1 and 3 are empty, tile 5 is the only tile of an empty batch
+        TileQueryResult result{6};
+        result.add_batch(make_result({
+            Row{2, int8(20), float8(2.0), "c"},
+            Row{0, int8(1), float8(0.5), "a"},
+            Row{2, int8(21), float8(2.5), ""},
+            Row{0, int8(2), float8(-0.5), "b"}
+        }), 0, 3);
+        // tile numbers are relative to the first tile of the batch
+        result.add_batch(make_result({
+            Row{1, big_endian<int16_t, uint16_t>(-40), big_endian<float, uint32_t>(4.5f), "d"}
+        }), 3, 5);
+        result.add_batch(make_result({}), 5, 6);
+
+        check(result.size() == 6, "wrong number of tiles");
+        const size_t expected_counts[] = {2, 0, 2, 0, 1, 0};
+        for (size_t t = 0; t < 6; ++t) {
+            check(result.feature_count(t) == expected_counts[t], "wrong number of features in tile " + std::to_string(t));
+        }
+        // features keep the order of the result within their tile
+        check(result.get_integer(0, 0, 0) == 1 && result.get_integer(0, 1, 0) == 2, "wrong features in tile 0");
+        check(result.get_integer(2, 0, 0) == 20 && result.get_integer(2, 1, 0) == 21, "wrong features in tile 2");
+        check(result.get_integer(4, 0, 0) == -40, "wrong feature in tile 4");
+        check(result.get_real(0, 1, 1) == -0.5 && result.get_real(2, 1, 1) == 2.5, "wrong float8 value");
+        check(result.get_real(4, 0, 1) == 4.5, "wrong float4 value");
+        check(result.get_string(0, 0, 2) == "a" && result.get_string(4, 0, 2) == "d", "wrong text value");
+        check(result.is_null(2, 1, 2) && !result.is_null(2, 0, 2), "wrong NULL value");
+
+        bool failed = false;
+        try {
+            result.get_real(0, 0, 2);
+        } catch (const std::runtime_error&) {
+            failed = true;
+        }
+        check(failed, "text decoded as floating point number");
+    }
+
+    void test_invalid_tile() {
+        TileQueryResult result{2};
+        bool failed = false;
+        try {
+            result.add_batch(make_result({Row{2, int8(1), float8(0), "a"}}), 0, 2);
+        } catch (const std::runtime_error&) {
+            failed = true;
+        }
+        check(failed, "tile number outside of the batch accepted");
+    }
+}
+
+int main() {
+    test_read_big_endian();
+    test_grouping();
+    test_invalid_tile();
+    std::cout << "all tests passed\n";
+}
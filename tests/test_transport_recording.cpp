@@ -0,0 +1,171 @@
+/*
+ * test_transport_recording.cpp
+ *
+ *  Created on:  2026-10-18
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ *
+ *  Tests of RecordingTransport and ReplayTransport: a session with a fake connection is recorded
+ *  and played back without waiting, results are rebuilt with all their fields and values.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <postgres_drivers/transport_recording.hpp>
+
+#include "fake_transport.hpp"
+
+using namespace postgres_drivers;
+using test::check;
+
+namespace {
+
+    const char* recording_path = "test_transport_recording.rec";
+
+    /// values of the result of the prepared statement, the last column is NULL
+    const std::string values[] = {
+        std::string("tab\tnewline\ncr\rbackslash\\"),
+        std::string("\\N"),
+        std::string("control\x01\x1f\x7f" "and nul\0end", 21),
+        std::string("")
+    };
+
+    const char* field_name = "name\twith tab";
+
+    /**
+     * Fake connection returning a result with rows for prepared statements.
+     */
+    class ResultTransport : public test::FakeTransport {
+
+    public:
+        const char* error_message() override {
+            return "ERROR:\tsomething\nfailed";
+        }
+
+        PGresult* exec_prepared(const char* name, const int params_count, const char* const* param_values,
+                const int result_format) override {
+            PQclear(test::FakeTransport::exec_prepared(name, params_count, param_values, result_format));
+            PGresult* result = PQmakeEmptyPGresult(nullptr, PGRES_TUPLES_OK);
+            PGresAttDesc attributes[2] = {
+                {const_cast<char*>(field_name), 0, 0, 0, 25, -1, -1},
+                {const_cast<char*>("geom"), 0, 0, 1, 17, -1, -1}
+            };
+            PQsetResultAttrs(result, 2, attributes);
+            for (int r = 0; r < 4; ++r) {
+                PQsetvalue(result, r, 0, const_cast<char*>(values[r].data()), static_cast<int>(values[r].size()));
+                PQsetvalue(result, r, 1, nullptr, -1);
+            }
+            return result;
+        }
+    };
+
+    /**
+     * Run the same session against a live or a replaying transport.
+     */
+    void run_session(Transport& transport) {
+        PQclear(transport.exec("CREATE TABLE t (\"a\tb\" text)\n"));
+        PQclear(transport.prepare("get", "SELECT a FROM t WHERE b = $1", 1));
+        const char* const param_values[] = {"x", nullptr};
+        PGresult* result = transport.exec_prepared("get", 2, param_values, 1);
+        check(PQresultStatus(result) == PGRES_TUPLES_OK, "wrong result status");
+        check(PQntuples(result) == 4 && PQnfields(result) == 2, "wrong number of rows or fields");
+        check(std::string(PQfname(result, 0)) == field_name && std::string(PQfname(result, 1)) == "geom",
+                "wrong field names");
+        check(PQftype(result, 0) == 25 && PQftype(result, 1) == 17 && PQfformat(result, 1) == 1,
+                "wrong field types or formats");
+        for (int r = 0; r < 4; ++r) {
+            check(!PQgetisnull(result, r, 0), "value turned into NULL");
+            check(std::string(PQgetvalue(result, r, 0), PQgetlength(result, r, 0)) == values[r],
+                    "value " + std::to_string(r) + " changed");
+            check(PQgetisnull(result, r, 1), "NULL turned into a value");
+        }
+        PQclear(result);
+        check(std::string(transport.error_message()) == "ERROR:\tsomething\nfailed", "wrong error message");
+
+        check(transport.send_query("COPY t FROM STDIN") == 1, "send_query failed");
+        result = transport.get_result();
+        check(result && PQresultStatus(result) == PGRES_COMMAND_OK, "result of send_query lost");
+        PQclear(result);
+        check(transport.get_result() == nullptr, "result after the last one");
+        check(transport.put_copy_data("1\n", 2) == 1 && transport.put_copy_data("2\n", 2) == 1, "put_copy_data failed");
+        check(transport.put_copy_end(nullptr) == 1, "put_copy_end failed");
+        PQclear(transport.get_result());
+    }
+
+    void test_record_and_replay() {
+        {
+            RecordingTransport recorder{std::unique_ptr<Transport>{new ResultTransport()}, recording_path};
+            run_session(recorder);
+        }
+        ReplayTransport replay{recording_path, 0};
+        const auto start = std::chrono::steady_clock::now();
+        run_session(replay);
+        check(std::chrono::steady_clock::now() - start < std::chrono::seconds(1), "replay with factor 0 waited");
+    }
+
+    void test_diverged() {
+        ReplayTransport replay{recording_path, 0};
+        PQclear(replay.exec("CREATE TABLE t (\"a\tb\" text)\n"));
+        bool failed = false;
+        try {
+            // recorded statement is "get"
+            PQclear(replay.prepare("other", "SELECT 1", 0));
+        } catch (const std::runtime_error& e) {
+            failed = std::string(e.what()).find("diverged at line") != std::string::npos;
+        }
+        check(failed, "different prepared statement not detected");
+
+        ReplayTransport short_replay{recording_path, 0};
+        run_session(short_replay);
+        failed = false;
+        try {
+            short_replay.send_query("SELECT 1");
+        } catch (const std::runtime_error&) {
+            failed = true;
+        }
+        check(failed, "operation after the end of the recording not detected");
+    }
+
+    void test_latency_debt() {
+        // 40 operations of 0.3 ms each and COPY data taking 2 ms in total, all shorter than the
+        // minimum sleep on their own
+        {
+            std::ofstream out{recording_path, std::ios::binary | std::ios::trunc};
+            out << detail::transport_recording_header << '\n';
+            for (int i = 0; i < 40; ++i) {
+                out << "put_copy_data\t50000\t1\t\t2\n";
+                out << "send_query\t300000\t1\t\tSELECT 1\n";
+            }
+        }
+        ReplayTransport replay{recording_path, 1.0, 100000};
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < 40; ++i) {
+            replay.send_query("SELECT 1");
+        }
+        const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count();
+        // 18 ms recorded and added, less than 1 ms may still be owed
+        check(elapsed >= 17000, "short waits were dropped instead of accumulated (" + std::to_string(elapsed) + "us)");
+        check(elapsed < 1000000, "replay waited far too long (" + std::to_string(elapsed) + "us)");
+
+        ReplayTransport fast{recording_path, 0};
+        const auto fast_start = std::chrono::steady_clock::now();
+        for (int i = 0; i < 40; ++i) {
+            fast.send_query("SELECT 1");
+        }
+        check(std::chrono::steady_clock::now() - fast_start < std::chrono::milliseconds(10),
+                "replay with factor 0 waited");
+    }
+}
+
+int main() {
+    test_record_and_replay();
+    test_diverged();
+    test_latency_debt();
+    std::remove(recording_path);
+    std::cout << "all tests passed\n";
+}
@@ -0,0 +1,182 @@
+/*
+ * load_copy_dump.cpp
+ *
+ *  Created on:  2026-10-18
+ *      Author: Michael Reichert <michael.reichert@geofabrik.de>
+ *
+ *  Load dumps written by CopyDumpSink into a database. The chunks of all tables are loaded in
+ *  parallel, each worker uses its own connection. Each chunk is loaded by its own COPY command
+ *  (and transaction).
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/format.hpp>
+#include <libpq-fe.h>
+
+#include <postgres_drivers/copy_dump.hpp>
+
+using namespace postgres_drivers;
+
+namespace {
+
+    struct Options {
+        /// libpq connection string
+        std::string conninfo = "";
+        size_t jobs = 4;
+        std::vector<std::string> manifests;
+    };
+
+    void print_help() {
+        std::cerr << "Usage: load_copy_dump [OPTIONS] MANIFEST...\n\n"
+                << "  --conninfo STR   libpq connection string (default: libpq environment variables)\n"
+                << "  --jobs N         number of parallel connections (default: 4)\n";
+    }
+
+    Options parse_options(int argc, char* argv[]) {
+        Options options;
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (arg == "--help" || arg == "-h") {
+                print_help();
+                exit(0);
+            } else if (i + 1 < argc && arg == "--conninfo") {
+                options.conninfo = argv[++i];
+            } else if (i + 1 < argc && arg == "--jobs") {
+                options.jobs = std::max(std::strtoul(argv[++i], nullptr, 10), 1ul);
+            } else if (arg.compare(0, 2, "--") == 0) {
+                print_help();
+                exit(1);
+            } else {
+                options.manifests.push_back(arg);
+            }
+        }
+        if (options.manifests.empty()) {
+            print_help();
+            exit(1);
+        }
+        return options;
+    }
+
+    struct Task {
+        const CopyDumpManifest* manifest;
+        std::string path;
+        const CopyDumpChunk* chunk;
+    };
+
+    std::string directory_of(const std::string& path) {
+        const size_t slash = path.rfind('/');
+        return slash == std::string::npos ? "." : path.substr(0, slash);
+    }
+
+    /**
+     * Load a chunk using the COPY command it was written for.
+     */
+    void load_chunk(PGconn* connection, const Task& task) {
+        PGresult* result = PQexec(connection, task.chunk->copy_command.c_str());
+        if (PQresultStatus(result) != PGRES_COPY_IN) {
+            PQclear(result);
+            throw std::runtime_error((boost::format("%1% failed: %2%\n") % task.chunk->copy_command
+                    % PQerrorMessage(connection)).str());
+        }
+        PQclear(result);
+        auto in = open_chunk_file(task.path, task.manifest->compression);
+        std::vector<char> buffer(1024 * 1024);
+        while (*in) {
+            in->read(buffer.data(), buffer.size());
+            const std::streamsize count = in->gcount();
+            if (count > 0 && PQputCopyData(connection, buffer.data(), static_cast<int>(count)) != 1) {
+                throw std::runtime_error((boost::format("Loading %1% failed: %2%\n") % task.path
+                        % PQerrorMessage(connection)).str());
+            }
+        }
+        if (in->bad()) {
+            PQputCopyEnd(connection, "reading the chunk failed");
+            PQclear(PQgetResult(connection));
+            throw std::runtime_error((boost::format("Reading %1% failed\n") % task.path).str());
+        }
+        if (PQputCopyEnd(connection, nullptr) != 1) {
+            throw std::runtime_error(PQerrorMessage(connection));
+        }
+        result = PQgetResult(connection);
+        if (PQresultStatus(result) != PGRES_COMMAND_OK) {
+            PQclear(result);
+            throw std::runtime_error((boost::format("Loading %1% failed: %2%\n") % task.path
+                    % PQerrorMessage(connection)).str());
+        }
+        PQclear(result);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const Options options = parse_options(argc, argv);
+    std::vector<CopyDumpManifest> manifests;
+    std::vector<Task> tasks;
+    try {
+        for (const std::string& path : options.manifests) {
+            manifests.push_back(CopyDumpManifest::read(path));
+        }
+    } catch (std::exception& e) {
+        std::cerr << e.what();
+        return 1;
+    }
+    size_t total_bytes = 0;
+    size_t total_rows = 0;
+    for (size_t i = 0; i < manifests.size(); ++i) {
+        const std::string directory = directory_of(options.manifests[i]);
+        for (const CopyDumpChunk& chunk : manifests[i].chunks) {
+            tasks.push_back(Task{&manifests[i], directory + "/" + chunk.file, &chunk});
+            total_bytes += chunk.bytes;
+            total_rows += chunk.rows;
+        }
+    }
+    // Start with the largest chunks to keep all workers busy until the end.
+    std::sort(tasks.begin(), tasks.end(), [](const Task& lhs, const Task& rhs) {
+        return lhs.chunk->bytes > rhs.chunk->bytes;
+    });
+
+    const auto start = std::chrono::steady_clock::now();
+    std::atomic<size_t> next_task{0};
+    std::atomic<bool> failed{false};
+    std::mutex error_mutex;
+    std::vector<std::thread> workers;
+    for (size_t j = 0; j < std::min(options.jobs, tasks.size()); ++j) {
+        workers.emplace_back([&]() {
+            PGconn* connection = PQconnectdb(options.conninfo.c_str());
+            try {
+                if (PQstatus(connection) != CONNECTION_OK) {
+                    throw std::runtime_error((boost::format("Cannot establish connection to database: %1%\n")
+                            % PQerrorMessage(connection)).str());
+                }
+                size_t index;
+                while (!failed && (index = next_task++) < tasks.size()) {
+                    load_chunk(connection, tasks[index]);
+                }
+            } catch (std::exception& e) {
+                failed = true;
+                std::lock_guard<std::mutex> lock{error_mutex};
+                std::cerr << e.what();
+            }
+            PQfinish(connection);
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    if (failed) {
+        return 1;
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << (boost::format("Loaded %1% chunks, %2% rows, %3% bytes in %4$.1f s (%5$.1f MB/s)\n") % tasks.size()
+            % total_rows % total_bytes % seconds % (total_bytes / seconds / (1024 * 1024)));
+    return 0;
+}